@@ -0,0 +1,74 @@
+#include "DrawList.h"
+#include "MemoryTracker.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+DrawList::DrawList(void) {
+	vertex_buffer = NULL;
+	vertex_count = 0;
+	vertex_capacity = 0;
+
+	color_r = color_g = color_b = 1.0f;
+	revision = 0;
+}
+
+DrawList::~DrawList(void) {
+	MemoryTracker::Free(vertex_buffer);
+	vertex_buffer = NULL;
+}
+
+void DrawList::Clear(void) {
+	// The buffer is kept around, so rebuilding a list of similar size doesn't allocate.
+	vertex_count = 0;
+	revision = 0;
+}
+
+void DrawList::SetColor(float r, float g, float b) {
+	color_r = r;
+	color_g = g;
+	color_b = b;
+}
+
+void DrawList::AddVertex(float x, float y, float z) {
+	if (vertex_count == vertex_capacity) {
+		int capacity = vertex_capacity ? vertex_capacity * 2 : 1024;
+
+		DrawVertex* buffer = MemoryTracker::AllocateArray<DrawVertex>(capacity, MemoryTracker::Meshes);
+		if (vertex_buffer) memcpy(buffer, vertex_buffer, sizeof(DrawVertex) * vertex_count);
+
+		MemoryTracker::Free(vertex_buffer);
+		vertex_buffer = buffer;
+		vertex_capacity = capacity;
+	}
+
+	DrawVertex* vertex = &vertex_buffer[vertex_count++];
+
+	vertex->x = x;
+	vertex->y = y;
+	vertex->z = z;
+	vertex->r = color_r;
+	vertex->g = color_g;
+	vertex->b = color_b;
+}
+
+DrawVertex* DrawList::GetVertices(void) {
+	return vertex_buffer;
+}
+
+int DrawList::GetVertexCount(void) {
+	return vertex_count;
+}
+
+int DrawList::GetTriangleCount(void) {
+	return vertex_count / 3;
+}
+
+unsigned int DrawList::GetRevision(void) {
+	return revision;
+}
+
+void DrawList::SetRevision(unsigned int revision) {
+	this->revision = revision;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// A DrawList collects colored triangles in the same way the fixed-function pipeline takes them.
+// SetColor() sets the color for the following vertices, and every three calls to AddVertex() form one triangle.
+// Nothing in here touches OpenGL, so draw lists can be built and checked without a context.
+
+struct DrawVertex {
+	float x, y, z;
+	float r, g, b;
+};
+
+class DrawList {
+public:
+	DrawList(void);
+	~DrawList(void);
+
+	void Clear(void);
+	void SetColor(float r, float g, float b);
+	void AddVertex(float x, float y, float z);
+
+	DrawVertex* GetVertices(void);
+	int GetVertexCount(void);
+	int GetTriangleCount(void);
+
+	unsigned int GetRevision(void);
+	void SetRevision(unsigned int revision);
+private:
+	DrawVertex* vertex_buffer;
+	int vertex_count, vertex_capacity;
+
+	float color_r, color_g, color_b;
+	unsigned int revision; // The VoxelGrid revision this list was built from.
+};
@@ -0,0 +1,33 @@
+#include "GLRenderBackend.h"
+
+#include <GL/gl.h>
+#include <GL/glu.h>
+
+void GLRenderBackend::Begin(RenderView* view) {
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	gluPerspective(view->fov, (float) view->width / (float) view->height, view->near_plane, view->far_plane);
+
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	gluLookAt(view->eye_x, view->eye_y, view->eye_z, view->target_x, view->target_y, view->target_z, 0.0f, 1.0f, 0.0f);
+
+	glClearColor(view->clear_r, view->clear_g, view->clear_b, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void GLRenderBackend::Draw(DrawList* source) {
+	DrawVertex* vertices = source->GetVertices();
+
+	glBegin(GL_TRIANGLES);
+
+	for (int i = 0; i < source->GetVertexCount(); i++) {
+		glColor4f(vertices[i].r, vertices[i].g, vertices[i].b, 1.0f);
+		glVertex3f(vertices[i].x, vertices[i].y, vertices[i].z);
+	}
+
+	glEnd();
+}
+
+void GLRenderBackend::End(void) {
+}
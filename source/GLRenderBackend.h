@@ -0,0 +1,12 @@
+#pragma once
+
+#include "RenderBackend.h"
+
+// Draws straight to the current OpenGL context. The window and context are the caller's business.
+
+class GLRenderBackend : public RenderBackend {
+public:
+	void Begin(RenderView* view);
+	void Draw(DrawList* source);
+	void End(void);
+};
@@ -0,0 +1,79 @@
+#include "Input.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+static const char* input_stream_header = "VoxelInput 1";
+
+InputStream::InputStream(void) {
+	file = NULL;
+	recording = false;
+}
+
+InputStream::~InputStream(void) {
+	Close();
+}
+
+bool InputStream::OpenRecord(const char* path) {
+	Close();
+
+	file = fopen(path, "w");
+
+	if (!file) {
+		printf("[InputStream::OpenRecord] Failed to open %s for writing!\n", path);
+		return false;
+	}
+
+	fprintf(file, "%s\n", input_stream_header);
+	recording = true;
+
+	return true;
+}
+
+bool InputStream::OpenReplay(const char* path) {
+	Close();
+
+	file = fopen(path, "r");
+
+	if (!file) {
+		printf("[InputStream::OpenReplay] Failed to open %s for reading!\n", path);
+		return false;
+	}
+
+	char header[64] = {0};
+
+	if (!fgets(header, sizeof header, file) || strncmp(header, input_stream_header, strlen(input_stream_header))) {
+		printf("[InputStream::OpenReplay] %s is not an input recording!\n", path);
+		Close();
+		return false;
+	}
+
+	recording = false;
+	return true;
+}
+
+void InputStream::Close(void) {
+	if (file) {
+		fclose(file);
+		file = NULL;
+	}
+}
+
+void InputStream::Write(unsigned int input) {
+	if (!file || !recording) return;
+
+	fprintf(file, "%u\n", input);
+}
+
+bool InputStream::Read(unsigned int* input) {
+	// Returns false once the recording runs out.
+
+	if (!file || recording) return false;
+
+	return fscanf(file, "%u", input) == 1;
+}
+
+bool InputStream::IsOpen(void) {
+	return file != NULL;
+}
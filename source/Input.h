@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdio>
+
+// Per-frame input is reduced to a bitmask of InputStream::InputFlag values, so the simulation never reads the keyboard directly.
+// An InputStream records those masks to a file, one frame per line, or plays them back from one.
+
+class InputStream {
+public:
+	enum InputFlag {
+		LookLeft = 1 << 0,
+		LookRight = 1 << 1,
+		Forward = 1 << 2,
+		Backward = 1 << 3,
+		StrafeLeft = 1 << 4,
+		StrafeRight = 1 << 5,
+		Jump = 1 << 6,
+		Quit = 1 << 7,
+	};
+
+	InputStream(void);
+	~InputStream(void);
+
+	bool OpenRecord(const char* path);
+	bool OpenReplay(const char* path);
+	void Close(void);
+
+	void Write(unsigned int input);
+	bool Read(unsigned int* input);
+	bool IsOpen(void);
+private:
+	FILE* file;
+	bool recording;
+};
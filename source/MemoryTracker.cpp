@@ -0,0 +1,201 @@
+#include "MemoryTracker.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <atomic>
+#include <new>
+
+// Each block starts with a small header, so Free() knows the size and tag without a lookup table.
+// The header is padded to 16 bytes to keep the returned pointer as aligned as malloc() would.
+
+struct AllocationHeader {
+	size_t size;
+	int tag;
+};
+
+static const size_t allocation_header_size = 16;
+static_assert(sizeof(AllocationHeader) <= allocation_header_size, "AllocationHeader doesn't fit in its padding.");
+
+// These are all zero-initialized before any constructor runs, so allocations made during static initialization are safe.
+
+static std::atomic<size_t> memory_live_bytes[MemoryTracker::Total + 1];
+static std::atomic<size_t> memory_peak_bytes[MemoryTracker::Total + 1];
+static std::atomic<unsigned int> memory_frame_allocations[MemoryTracker::Total + 1];
+
+static std::atomic<bool> memory_steady_state;
+static std::atomic<unsigned int> memory_steady_state_allocations;
+static std::atomic<unsigned int> memory_allowed_allocations;
+static std::atomic<unsigned int> memory_exempt_allocations;
+
+static MemoryTracker::AllocateHook memory_allocate_hook = NULL;
+static MemoryTracker::FreeHook memory_free_hook = NULL;
+
+static const char* memory_tag_names[MemoryTracker::Total + 1] = {
+	"GridTables",
+	"VoxelPayloads",
+	"Meshes",
+	"Caches",
+	"Untagged",
+	"Total",
+};
+
+static void RaisePeak(int tag, size_t live) {
+	size_t peak = memory_peak_bytes[tag].load();
+	while (live > peak && !memory_peak_bytes[tag].compare_exchange_weak(peak, live));
+}
+
+void* MemoryTracker::Allocate(size_t size, Tag tag) {
+	void* block = memory_allocate_hook ? memory_allocate_hook(size + allocation_header_size, tag) : malloc(size + allocation_header_size);
+
+	if (!block) {
+		printf("[MemoryTracker::Allocate] Failed to allocate %zu bytes for %s!\n", size, memory_tag_names[tag]);
+		return NULL;
+	}
+
+	AllocationHeader* header = (AllocationHeader*) block;
+	header->size = size;
+	header->tag = tag;
+
+	RaisePeak(tag, memory_live_bytes[tag] += size);
+	RaisePeak(Total, memory_live_bytes[Total] += size);
+
+	memory_frame_allocations[tag]++;
+	memory_frame_allocations[Total]++;
+
+	if (memory_steady_state) {
+		unsigned int allowed = memory_allowed_allocations.load();
+		while (allowed && !memory_allowed_allocations.compare_exchange_weak(allowed, allowed - 1));
+
+		if (allowed) {
+			memory_exempt_allocations++;
+		} else {
+			memory_steady_state_allocations++;
+
+#ifdef VOXEL_MEMORY_DEBUG
+			printf("[MemoryTracker] %zu byte %s allocation in the steady-state frame loop!\n", size, memory_tag_names[tag]);
+#endif
+		}
+	}
+
+	return (char*) block + allocation_header_size;
+}
+
+void MemoryTracker::Free(void* pointer) {
+	if (!pointer) return;
+
+	void* block = (char*) pointer - allocation_header_size;
+	AllocationHeader* header = (AllocationHeader*) block;
+
+	memory_live_bytes[header->tag] -= header->size;
+	memory_live_bytes[Total] -= header->size;
+
+	if (memory_free_hook) {
+		memory_free_hook(block, (Tag) header->tag);
+	} else {
+		free(block);
+	}
+}
+
+void MemoryTracker::SetHooks(AllocateHook allocate, FreeHook free) {
+	// Blocks have to be released by the hooks that allocated them, so only swap hooks while nothing is live.
+
+	if (memory_live_bytes[Total]) {
+		printf("[MemoryTracker::SetHooks] Changing hooks with %zu bytes still allocated!\n", (size_t) memory_live_bytes[Total]);
+	}
+
+	memory_allocate_hook = allocate;
+	memory_free_hook = free;
+}
+
+size_t MemoryTracker::GetLiveBytes(Tag tag) {
+	return memory_live_bytes[tag];
+}
+
+size_t MemoryTracker::GetPeakBytes(Tag tag) {
+	return memory_peak_bytes[tag];
+}
+
+unsigned int MemoryTracker::GetFrameAllocations(Tag tag) {
+	return memory_frame_allocations[tag];
+}
+
+unsigned int MemoryTracker::GetSteadyStateAllocations(void) {
+	return memory_steady_state_allocations;
+}
+
+const char* MemoryTracker::GetTagName(Tag tag) {
+	return memory_tag_names[tag];
+}
+
+void MemoryTracker::BeginFrame(void) {
+	for (int i = 0; i <= Total; i++) {
+		memory_frame_allocations[i] = 0;
+	}
+}
+
+void MemoryTracker::SetSteadyState(bool steady) {
+	memory_steady_state = steady;
+}
+
+void MemoryTracker::AllowAllocations(unsigned int count) {
+	memory_allowed_allocations = count;
+}
+
+unsigned int MemoryTracker::GetExemptAllocations(void) {
+	return memory_exempt_allocations;
+}
+
+void MemoryTracker::PrintReport(void) {
+	printf("[MemoryTracker] %-14s %12s %12s %12s\n", "Tag", "Live bytes", "Peak bytes", "Frame allocs");
+
+	for (int i = 0; i <= Total; i++) {
+		printf("[MemoryTracker] %-14s %12zu %12zu %12u\n", memory_tag_names[i], (size_t) memory_live_bytes[i], (size_t) memory_peak_bytes[i], (unsigned int) memory_frame_allocations[i]);
+	}
+
+	printf("[MemoryTracker] Steady-state allocations : %u\n", (unsigned int) memory_steady_state_allocations);
+	printf("[MemoryTracker] Exempt allocations : %u\n", (unsigned int) memory_exempt_allocations);
+}
+
+#ifdef VOXEL_MEMORY_DEBUG
+
+// Everything else that hits the heap through new shows up as Untagged.
+
+void* operator new(size_t size) {
+	void* pointer = MemoryTracker::Allocate(size, MemoryTracker::Untagged);
+	if (!pointer) throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new[](size_t size) {
+	void* pointer = MemoryTracker::Allocate(size, MemoryTracker::Untagged);
+	if (!pointer) throw std::bad_alloc();
+
+	return pointer;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return MemoryTracker::Allocate(size, MemoryTracker::Untagged);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return MemoryTracker::Allocate(size, MemoryTracker::Untagged);
+}
+
+void operator delete(void* pointer) noexcept {
+	MemoryTracker::Free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	MemoryTracker::Free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+	MemoryTracker::Free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+	MemoryTracker::Free(pointer);
+}
+
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+// Every heap allocation made by the voxel subsystems goes through MemoryTracker with a tag saying who owns it.
+// It keeps live bytes, peak bytes and allocations since the last BeginFrame() per tag, and for all tags together under Total.
+// The actual memory comes from malloc() and free() unless other hooks are installed with SetHooks().
+
+// Call SetSteadyState(true) once the frame loop has warmed up; every allocation after that is counted as a steady-state allocation,
+// except for the ones granted up front with AllowAllocations(). Those are counted as exempt, and PrintReport() shows both numbers.
+// The only grant in the tree is VoxelGrid::Update(), which allows VOXEL_CHUNK_COMPRESS_ALLOCATIONS for each chunk it compresses.
+// Building with -DVOXEL_MEMORY_DEBUG also routes the global operator new through here as Untagged, so STL and other hidden allocations get caught,
+// and prints every steady-state allocation as it happens.
+
+class MemoryTracker {
+public:
+	enum Tag {
+		GridTables, // VoxelChunk tables, palettes and packed indices.
+		VoxelPayloads, // Voxel objects.
+		Meshes, // DrawList vertex buffers.
+		Caches, // Software render targets and tile bins.
+		Untagged, // Global operator new, only seen in VOXEL_MEMORY_DEBUG builds.
+		Total,
+	};
+
+	typedef void* (*AllocateHook)(size_t size, Tag tag);
+	typedef void (*FreeHook)(void* pointer, Tag tag);
+
+	static void* Allocate(size_t size, Tag tag);
+	static void Free(void* pointer);
+
+	// Allocate() returns NULL when it runs out of memory. AllocateArray() throws std::bad_alloc like new[] does.
+	template <typename T>
+	static T* AllocateArray(size_t count, Tag tag) {
+		T* pointer = (T*) Allocate(sizeof(T) * count, tag);
+		if (!pointer) throw std::bad_alloc();
+
+		return pointer;
+	}
+
+	static void SetHooks(AllocateHook allocate, FreeHook free); // Pass NULL to go back to malloc() and free().
+
+	static size_t GetLiveBytes(Tag tag);
+	static size_t GetPeakBytes(Tag tag);
+	static unsigned int GetFrameAllocations(Tag tag);
+	static unsigned int GetSteadyStateAllocations(void);
+	static const char* GetTagName(Tag tag);
+
+	static void BeginFrame(void);
+	static void SetSteadyState(bool steady);
+	static void AllowAllocations(unsigned int count); // The next count steady-state allocations are expected, and counted as exempt instead.
+	static unsigned int GetExemptAllocations(void);
+	static void PrintReport(void);
+};
+
+// Lets STL containers allocate under a tag, e.g. std::vector<int, TaggedAllocator<int, MemoryTracker::Caches> >.
+
+template <typename T, MemoryTracker::Tag tag>
+struct TaggedAllocator {
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind {
+		typedef TaggedAllocator<U, tag> other;
+	};
+
+	TaggedAllocator(void) {}
+
+	template <typename U>
+	TaggedAllocator(const TaggedAllocator<U, tag>&) {}
+
+	T* allocate(size_t count) {
+		return MemoryTracker::AllocateArray<T>(count, tag);
+	}
+
+	void deallocate(T* pointer, size_t) {
+		MemoryTracker::Free(pointer);
+	}
+};
+
+template <typename T, typename U, MemoryTracker::Tag tag>
+bool operator==(const TaggedAllocator<T, tag>&, const TaggedAllocator<U, tag>&) {
+	return true;
+}
+
+template <typename T, typename U, MemoryTracker::Tag tag>
+bool operator!=(const TaggedAllocator<T, tag>&, const TaggedAllocator<U, tag>&) {
+	return false;
+}
@@ -0,0 +1,81 @@
+#include "World.h"
+#include "SoftwareRenderBackend.h"
+#include "MemoryTracker.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+/* Offscreen map preview on the CPU.
+ * Generates the map, lets the camera settle at the spawn point, renders it with the SoftwareRenderBackend and writes a PPM image.
+ * Usage : EnvPreview [output.ppm] [width] [height] [frames] [threads]
+ * One untimed warm-up frame comes first, then the given number of frames are timed.
+ * Throughput is reported in frames per second, overall and per core actually in use.
+ */
+
+int main(int argc, char** argv) {
+	const char* output_path = argc > 1 ? argv[1] : "preview.ppm";
+
+	RenderView view;
+	view.width = argc > 2 ? atoi(argv[2]) : 740;
+	view.height = argc > 3 ? atoi(argv[3]) : 480;
+
+	int frames = argc > 4 ? atoi(argv[4]) : 1;
+	int threads = argc > 5 ? atoi(argv[5]) : 0;
+
+	if (view.width <= 0 || view.height <= 0 || frames <= 0) {
+		printf("Usage : %s [output.ppm] [width] [height] [frames] [threads]\n", argv[0]);
+		return 1;
+	}
+
+	VoxelGrid* grid = new VoxelGrid();
+	Camera camera;
+
+	GenerateVoxelMap(grid);
+
+	// The camera spawns in mid-air, give it a second to land.
+	for (int i = 0; i < 60; i++) StepCamera(grid, &camera, 0);
+
+	SetCameraView(&camera, &view);
+
+	SoftwareRenderBackend backend(threads);
+
+	// The warm-up frame sizes the framebuffer and grows the tile bins, so it stays out of the timing. The rest should reuse them.
+
+	backend.Begin(&view);
+	grid->DrawAll(&backend);
+	backend.End();
+
+	MemoryTracker::SetSteadyState(true);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < frames; i++) {
+		MemoryTracker::BeginFrame();
+
+		backend.Begin(&view);
+		grid->DrawAll(&backend);
+		backend.End();
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double fps = frames / seconds;
+
+	MemoryTracker::SetSteadyState(false);
+
+	// Threads past the core count only take turns, so they don't add to the per-core figure.
+	int cores = backend.GetThreadCount();
+	int hardware_threads = std::thread::hardware_concurrency();
+	if (hardware_threads > 0 && hardware_threads < cores) cores = hardware_threads;
+
+	printf("[Preview] %d frames at %dx%d on %d threads (%d cores) : %.2f fps, %.2f fps per core\n", frames, view.width, view.height, backend.GetThreadCount(), cores, fps, fps / cores);
+
+	MemoryTracker::PrintReport();
+
+	bool result = backend.WritePPM(output_path);
+	if (result) printf("[Preview] Wrote %s.\n", output_path);
+
+	delete grid;
+	return result ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "DrawList.h"
+
+// A RenderBackend turns DrawLists into pixels. VoxelGrid::DrawAll() only talks to this interface.
+// GLRenderBackend draws through the fixed-function pipeline, SoftwareRenderBackend rasterizes on the CPU into memory.
+
+// Call Begin() once per frame with the camera, then Draw() any number of lists, then End().
+
+struct RenderView {
+	float eye_x = 0.0f, eye_y = 0.0f, eye_z = 0.0f;
+	float target_x = 0.0f, target_y = 0.0f, target_z = -1.0f;
+
+	float fov = 90.0f;
+	float near_plane = 0.1f, far_plane = 180.0f;
+	int width = 740, height = 480;
+
+	float clear_r = 0.0f, clear_g = 0.5f, clear_b = 0.8f;
+};
+
+class RenderBackend {
+public:
+	virtual ~RenderBackend(void) {}
+
+	virtual void Begin(RenderView* view) = 0;
+	virtual void Draw(DrawList* source) = 0;
+	virtual void End(void) = 0;
+};
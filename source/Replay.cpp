@@ -0,0 +1,107 @@
+#include "World.h"
+#include "Input.h"
+#include "MemoryTracker.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+
+/* Headless replay of a recorded input file.
+ * Runs the same per-frame work as the interactive program (camera simulation, draw list submission, chunk compression)
+ * without a window or an OpenGL context, then prints per-frame timings and a checksum of the final state.
+ * Frames are submitted to a NullRenderBackend, so the timings cover everything but the GPU itself.
+ * Every frame after the first counts as steady state; VOXEL_MEMORY_DEBUG builds fail the replay if any of them allocate outside the chunk compression budget.
+ * Record a session with "EnvOutput --record <file>", then run "EnvReplay <file>".
+ */
+
+// Accepts frames like a real backend would, and only counts what it was given.
+
+class NullRenderBackend : public RenderBackend {
+public:
+	NullRenderBackend(void) {
+		triangles = 0;
+	}
+
+	void Begin(RenderView*) {}
+
+	void Draw(DrawList* source) {
+		triangles += source->GetTriangleCount();
+	}
+
+	void End(void) {}
+
+	unsigned long long GetTriangleCount(void) {
+		return triangles;
+	}
+private:
+	unsigned long long triangles;
+};
+
+int main(int argc, char** argv) {
+	if (argc != 2) {
+		printf("Usage : %s <input recording>\n", argv[0]);
+		return 1;
+	}
+
+	InputStream input_stream;
+	if (!input_stream.OpenReplay(argv[1])) return 1;
+
+	VoxelGrid* grid = new VoxelGrid();
+	Camera camera;
+	RenderView view;
+	NullRenderBackend backend;
+
+	GenerateVoxelMap(grid);
+
+	unsigned int input = 0;
+	unsigned int frame = 0;
+	double total_ms = 0.0, min_ms = 0.0, max_ms = 0.0;
+
+	while (input_stream.Read(&input)) {
+		MemoryTracker::BeginFrame();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		StepCamera(grid, &camera, input);
+		SetCameraView(&camera, &view);
+
+		backend.Begin(&view);
+		grid->DrawAll(&backend);
+		backend.End();
+
+		int compressed = grid->Update();
+
+		double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		printf("[Replay] Frame %u : %.3f ms, %u allocations, %d chunks compressed\n", frame, frame_ms, MemoryTracker::GetFrameAllocations(MemoryTracker::Total), compressed);
+
+		if (!frame || frame_ms < min_ms) min_ms = frame_ms;
+		if (!frame || frame_ms > max_ms) max_ms = frame_ms;
+		total_ms += frame_ms;
+		frame++;
+
+		// The first frame builds the draw list, nothing after it should need the heap.
+		MemoryTracker::SetSteadyState(true);
+
+		if (input & InputStream::Quit) break;
+	}
+
+	if (frame) {
+		printf("[Replay] %u frames : min %.3f ms, mean %.3f ms, max %.3f ms\n", frame, min_ms, total_ms / frame, max_ms);
+	}
+
+	printf("[Replay] Triangles : %d, %llu submitted\n", grid->GetDrawList()->GetTriangleCount(), backend.GetTriangleCount());
+	printf("[Replay] Compressed chunks : %d\n", grid->GetCompressedChunkCount());
+	printf("[Replay] Checksum : %08x\n", ChecksumState(&camera, grid->GetDrawList()));
+
+	MemoryTracker::SetSteadyState(false);
+	MemoryTracker::PrintReport();
+
+	delete grid;
+
+#ifdef VOXEL_MEMORY_DEBUG
+	if (MemoryTracker::GetSteadyStateAllocations()) return 1;
+#endif
+
+	return 0;
+}
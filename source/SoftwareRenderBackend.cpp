@@ -0,0 +1,535 @@
+#include "SoftwareRenderBackend.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static_assert(SOFTWARE_RENDER_TILE_SIZE % 4 == 0, "SOFTWARE_RENDER_TILE_SIZE must be a multiple of the 4-pixel SIMD width.");
+
+static uint32_t PackColor(float r, float g, float b) {
+	float channels[3] = { r, g, b };
+	uint32_t packed = 0xFF000000u;
+
+	for (int i = 0; i < 3; i++) {
+		float value = channels[i] < 0.0f ? 0.0f : (channels[i] > 1.0f ? 1.0f : channels[i]);
+		packed |= (uint32_t) (value * 255.0f + 0.5f) << (i * 8);
+	}
+
+	return packed;
+}
+
+static void BuildViewProjection(RenderView* view, float* matrix) {
+	// Same matrices as gluPerspective() and gluLookAt() with a +Y up vector, multiplied together.
+
+	float f = 1.0f / tanf(view->fov * 3.14159265f / 360.0f);
+	float aspect = (float) view->width / (float) view->height;
+	float near_plane = view->near_plane, far_plane = view->far_plane;
+
+	float forward[3] = { view->target_x - view->eye_x, view->target_y - view->eye_y, view->target_z - view->eye_z };
+	float forward_length = sqrtf(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+	for (int i = 0; i < 3; i++) forward[i] /= forward_length;
+
+	float side[3] = { -forward[2], 0.0f, forward[0] }; // forward x (0, 1, 0)
+	float side_length = sqrtf(side[0] * side[0] + side[2] * side[2]);
+	for (int i = 0; i < 3; i++) side[i] /= side_length;
+
+	float up[3] = { side[1] * forward[2] - side[2] * forward[1], side[2] * forward[0] - side[0] * forward[2], side[0] * forward[1] - side[1] * forward[0] };
+	float eye[3] = { view->eye_x, view->eye_y, view->eye_z };
+
+	float look[16] = {0};
+	float projection[16] = {0};
+
+	for (int i = 0; i < 3; i++) {
+		look[i * 4 + 0] = side[i];
+		look[i * 4 + 1] = up[i];
+		look[i * 4 + 2] = -forward[i];
+	}
+
+	look[12] = -(side[0] * eye[0] + side[1] * eye[1] + side[2] * eye[2]);
+	look[13] = -(up[0] * eye[0] + up[1] * eye[1] + up[2] * eye[2]);
+	look[14] = forward[0] * eye[0] + forward[1] * eye[1] + forward[2] * eye[2];
+	look[15] = 1.0f;
+
+	projection[0] = f / aspect;
+	projection[5] = f;
+	projection[10] = (far_plane + near_plane) / (near_plane - far_plane);
+	projection[11] = -1.0f;
+	projection[14] = 2.0f * far_plane * near_plane / (near_plane - far_plane);
+
+	for (int column = 0; column < 4; column++) {
+		for (int row = 0; row < 4; row++) {
+			float sum = 0.0f;
+			for (int k = 0; k < 4; k++) sum += projection[k * 4 + row] * look[column * 4 + k];
+			matrix[column * 4 + row] = sum;
+		}
+	}
+}
+
+SoftwareRenderBackend::SoftwareRenderBackend(int thread_count) {
+	if (thread_count <= 0) thread_count = std::thread::hardware_concurrency();
+	if (thread_count <= 0) thread_count = 1;
+
+	this->thread_count = thread_count;
+	bins.resize(thread_count);
+
+	width = height = pitch = 0;
+	tiles_x = tiles_y = 0;
+	color_buffer = NULL;
+	depth_buffer = NULL;
+
+	memset(view_projection, 0, sizeof view_projection);
+	clear_color = 0;
+	clear_pending = false;
+	next_tile = 0;
+
+	worker_generation = 0;
+	workers_pending = 0;
+	worker_phase = SetupPhase;
+	worker_source = NULL;
+	workers_exit = false;
+
+	for (int i = 1; i < thread_count; i++) {
+		workers.push_back(std::thread(&SoftwareRenderBackend::WorkerLoop, this, i));
+	}
+}
+
+SoftwareRenderBackend::~SoftwareRenderBackend(void) {
+	{
+		std::lock_guard<std::mutex> lock(worker_mutex);
+		workers_exit = true;
+	}
+
+	worker_start.notify_all();
+	for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+
+	MemoryTracker::Free(color_buffer);
+	MemoryTracker::Free(depth_buffer);
+}
+
+void SoftwareRenderBackend::Resize(int width, int height) {
+	// Rows are padded to a multiple of 4 pixels, so the SIMD loop never needs a scalar tail.
+
+	MemoryTracker::Free(color_buffer);
+	MemoryTracker::Free(depth_buffer);
+
+	this->width = width;
+	this->height = height;
+	pitch = (width + 3) & ~3;
+
+	color_buffer = MemoryTracker::AllocateArray<uint32_t>(pitch * height, MemoryTracker::Caches);
+	depth_buffer = MemoryTracker::AllocateArray<float>(pitch * height, MemoryTracker::Caches);
+
+	tiles_x = (width + SOFTWARE_RENDER_TILE_SIZE - 1) / SOFTWARE_RENDER_TILE_SIZE;
+	tiles_y = (height + SOFTWARE_RENDER_TILE_SIZE - 1) / SOFTWARE_RENDER_TILE_SIZE;
+
+	for (int i = 0; i < thread_count; i++) {
+		bins[i].tiles.resize(tiles_x * tiles_y);
+	}
+}
+
+void SoftwareRenderBackend::Begin(RenderView* view) {
+	if (view->width != width || view->height != height) {
+		Resize(view->width, view->height);
+	}
+
+	// The clear is only recorded here. The first tile pass of the frame applies it, one tile per worker.
+
+	BuildViewProjection(view, view_projection);
+	clear_color = PackColor(view->clear_r, view->clear_g, view->clear_b);
+	clear_pending = true;
+}
+
+void SoftwareRenderBackend::Draw(DrawList* source) {
+	if (!color_buffer) {
+		printf("[SoftwareRenderBackend::Draw] Draw() called before Begin()!\n");
+		return;
+	}
+
+	worker_source = source;
+	RunWorkers(SetupPhase);
+
+	// Every tile is binned now, so the threads can fill tiles without touching each other's pixels.
+
+	next_tile = 0;
+	RunWorkers(RasterizePhase);
+
+	worker_source = NULL;
+	clear_pending = false;
+}
+
+void SoftwareRenderBackend::End(void) {
+	if (!clear_pending) return;
+
+	// Nothing was drawn this frame, so run a tile pass over empty bins just to clear.
+
+	for (int i = 0; i < thread_count; i++) {
+		bins[i].triangles.clear();
+		for (size_t tile = 0; tile < bins[i].tiles.size(); tile++) bins[i].tiles[tile].clear();
+	}
+
+	next_tile = 0;
+	RunWorkers(RasterizePhase);
+
+	clear_pending = false;
+}
+
+void SoftwareRenderBackend::RunPhase(WorkerPhase phase, int thread) {
+	switch (phase) {
+	case SetupPhase:
+		SetupTriangles(worker_source, thread);
+		break;
+	case RasterizePhase:
+		RasterizeTiles();
+		break;
+	}
+}
+
+void SoftwareRenderBackend::RunWorkers(WorkerPhase phase) {
+	// Wakes the workers for one phase, does this thread's share, then waits for the rest.
+
+	{
+		std::lock_guard<std::mutex> lock(worker_mutex);
+		worker_phase = phase;
+		workers_pending = thread_count - 1;
+		worker_generation++;
+	}
+
+	worker_start.notify_all();
+	RunPhase(phase, 0);
+
+	std::unique_lock<std::mutex> lock(worker_mutex);
+	worker_done.wait(lock, [this] { return workers_pending == 0; });
+}
+
+void SoftwareRenderBackend::WorkerLoop(int thread) {
+	unsigned int generation = 0;
+
+	while (true) {
+		WorkerPhase phase;
+
+		{
+			std::unique_lock<std::mutex> lock(worker_mutex);
+			worker_start.wait(lock, [this, generation] { return workers_exit || worker_generation != generation; });
+
+			if (workers_exit) return;
+
+			generation = worker_generation;
+			phase = worker_phase;
+		}
+
+		RunPhase(phase, thread);
+
+		{
+			std::lock_guard<std::mutex> lock(worker_mutex);
+			if (--workers_pending == 0) worker_done.notify_one();
+		}
+	}
+}
+
+void SoftwareRenderBackend::SetupTriangles(DrawList* source, int thread) {
+	// Each thread takes one contiguous slice of the list, which keeps the bins in submission order.
+
+	TriangleBin* bin = &bins[thread];
+
+	bin->triangles.clear();
+	for (size_t i = 0; i < bin->tiles.size(); i++) bin->tiles[i].clear();
+
+	int triangle_count = source->GetTriangleCount();
+	int first = (int) ((long long) triangle_count * thread / thread_count);
+	int last = (int) ((long long) triangle_count * (thread + 1) / thread_count);
+
+	DrawVertex* vertices = source->GetVertices();
+
+	for (int triangle = first; triangle < last; triangle++) {
+		DrawVertex* corner = &vertices[triangle * 3];
+		float clip[3][4];
+
+		for (int i = 0; i < 3; i++) {
+			for (int row = 0; row < 4; row++) {
+				clip[i][row] = view_projection[row] * corner[i].x + view_projection[4 + row] * corner[i].y + view_projection[8 + row] * corner[i].z + view_projection[12 + row];
+			}
+		}
+
+		// Throw out triangles entirely outside one of the frustum planes before doing any real work.
+
+		bool outside = false;
+
+		for (int axis = 0; axis < 3 && !outside; axis++) {
+			outside |= clip[0][axis] > clip[0][3] && clip[1][axis] > clip[1][3] && clip[2][axis] > clip[2][3];
+			outside |= clip[0][axis] < -clip[0][3] && clip[1][axis] < -clip[1][3] && clip[2][axis] < -clip[2][3];
+		}
+
+		if (outside) continue;
+
+		// DrawList triangles are flat colored (one SetColor() per face), so the first vertex is enough.
+
+		uint32_t color = PackColor(corner[0].r, corner[0].g, corner[0].b);
+
+		// Clip against the near plane (z >= -w). The other planes are handled by clamping to the screen.
+
+		float polygon[4][4];
+		int polygon_size = 0;
+
+		for (int i = 0; i < 3; i++) {
+			float* current = clip[i];
+			float* next = clip[(i + 1) % 3];
+
+			float current_distance = current[2] + current[3];
+			float next_distance = next[2] + next[3];
+
+			if (current_distance >= 0.0f) {
+				memcpy(polygon[polygon_size++], current, sizeof(float) * 4);
+			}
+
+			if ((current_distance >= 0.0f) != (next_distance >= 0.0f)) {
+				float t = current_distance / (current_distance - next_distance);
+				for (int k = 0; k < 4; k++) polygon[polygon_size][k] = current[k] + (next[k] - current[k]) * t;
+				polygon_size++;
+			}
+		}
+
+		for (int i = 1; i + 1 < polygon_size; i++) {
+			EmitTriangle(bin, polygon[0], polygon[i], polygon[i + 1], color);
+		}
+	}
+}
+
+void SoftwareRenderBackend::EmitTriangle(TriangleBin* bin, float* a, float* b, float* c, uint32_t color) {
+	float* clip[3] = { a, b, c };
+	float x[3], y[3], z[3];
+
+	for (int i = 0; i < 3; i++) {
+		float inverse_w = 1.0f / clip[i][3];
+
+		x[i] = (clip[i][0] * inverse_w * 0.5f + 0.5f) * width;
+		y[i] = (0.5f - clip[i][1] * inverse_w * 0.5f) * height; // Row 0 is the top of the image.
+		z[i] = clip[i][2] * inverse_w * 0.5f + 0.5f;
+	}
+
+	// Front faces are counter-clockwise in OpenGL window space, which is clockwise once Y points down.
+	// Cull like glEnable(GL_CULL_FACE), then swap two corners so the inside of every triangle is positive.
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!(area < 0.0f)) return;
+
+	float swap;
+	swap = x[1]; x[1] = x[2]; x[2] = swap;
+	swap = y[1]; y[1] = y[2]; y[2] = swap;
+	swap = z[1]; z[1] = z[2]; z[2] = swap;
+
+	ScreenTriangle triangle;
+
+	float min_x = fminf(x[0], fminf(x[1], x[2])), max_x = fmaxf(x[0], fmaxf(x[1], x[2]));
+	float min_y = fminf(y[0], fminf(y[1], y[2])), max_y = fmaxf(y[0], fmaxf(y[1], y[2]));
+
+	triangle.min_x = min_x < 0.0f ? 0 : (int) min_x;
+	triangle.min_y = min_y < 0.0f ? 0 : (int) min_y;
+	triangle.max_x = max_x >= width ? width - 1 : (int) max_x;
+	triangle.max_y = max_y >= height ? height - 1 : (int) max_y;
+
+	if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) return;
+
+	for (int k = 0; k < 3; k++) {
+		int from = (k + 1) % 3, to = (k + 2) % 3;
+
+		// A triangle sharing this edge walks it the other way, which negates a, b and c exactly.
+		// That way exactly one of the two owns the pixels that land right on the edge.
+
+		triangle.edge_a[k] = y[from] - y[to];
+		triangle.edge_b[k] = x[to] - x[from];
+		triangle.edge_c[k] = (float) ((double) x[from] * y[to] - (double) y[from] * x[to]);
+		triangle.edge_owner[k] = triangle.edge_a[k] > 0.0f || (triangle.edge_a[k] == 0.0f && triangle.edge_b[k] > 0.0f);
+		triangle.z[k] = z[k];
+	}
+
+	triangle.inverse_area = 1.0f / -area;
+	triangle.color = color;
+
+	int index = (int) bin->triangles.size();
+	bin->triangles.push_back(triangle);
+
+	for (int tile_y = triangle.min_y / SOFTWARE_RENDER_TILE_SIZE; tile_y <= triangle.max_y / SOFTWARE_RENDER_TILE_SIZE; tile_y++) {
+		for (int tile_x = triangle.min_x / SOFTWARE_RENDER_TILE_SIZE; tile_x <= triangle.max_x / SOFTWARE_RENDER_TILE_SIZE; tile_x++) {
+			bin->tiles[tile_y * tiles_x + tile_x].push_back(index);
+		}
+	}
+}
+
+void SoftwareRenderBackend::RasterizeTiles(void) {
+	int tile_count = tiles_x * tiles_y;
+
+	for (int tile = next_tile++; tile < tile_count; tile = next_tile++) {
+		RasterizeTile(tile);
+	}
+}
+
+void SoftwareRenderBackend::RasterizeTile(int tile) {
+	int tile_min_x = (tile % tiles_x) * SOFTWARE_RENDER_TILE_SIZE;
+	int tile_min_y = (tile / tiles_x) * SOFTWARE_RENDER_TILE_SIZE;
+	int tile_max_x = tile_min_x + SOFTWARE_RENDER_TILE_SIZE - 1;
+	int tile_max_y = tile_min_y + SOFTWARE_RENDER_TILE_SIZE - 1;
+
+	if (tile_max_x >= width) tile_max_x = width - 1;
+	if (tile_max_y >= height) tile_max_y = height - 1;
+
+	if (clear_pending) {
+		// The SIMD loop reads up to the padded row end, so the clear covers the padding too.
+
+		int clear_max_x = tile_min_x + SOFTWARE_RENDER_TILE_SIZE < pitch ? tile_min_x + SOFTWARE_RENDER_TILE_SIZE : pitch;
+
+		for (int y = tile_min_y; y <= tile_max_y; y++) {
+			for (int x = tile_min_x; x < clear_max_x; x++) {
+				color_buffer[y * pitch + x] = clear_color;
+				depth_buffer[y * pitch + x] = 1.0f;
+			}
+		}
+	}
+
+	for (int thread = 0; thread < thread_count; thread++) {
+		TriangleBin* bin = &bins[thread];
+		TileBin& indices = bin->tiles[tile];
+
+		for (size_t i = 0; i < indices.size(); i++) {
+			ScreenTriangle* triangle = &bin->triangles[indices[i]];
+
+			// Start on a 4-pixel boundary. Tiles and rows are multiples of 4 wide, so the last group stays in bounds.
+
+			int min_x = (triangle->min_x > tile_min_x ? triangle->min_x : tile_min_x) & ~3;
+			int max_x = triangle->max_x < tile_max_x ? triangle->max_x : tile_max_x;
+			int min_y = triangle->min_y > tile_min_y ? triangle->min_y : tile_min_y;
+			int max_y = triangle->max_y < tile_max_y ? triangle->max_y : tile_max_y;
+
+#ifdef __SSE2__
+			const __m128 lane_offset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128i color = _mm_set1_epi32((int) triangle->color);
+
+			__m128 edge_a[3], owner[3];
+
+			for (int k = 0; k < 3; k++) {
+				edge_a[k] = _mm_set1_ps(triangle->edge_a[k]);
+				owner[k] = _mm_castsi128_ps(_mm_set1_epi32(triangle->edge_owner[k] ? -1 : 0));
+			}
+
+			__m128 z0 = _mm_set1_ps(triangle->z[0] * triangle->inverse_area);
+			__m128 z1 = _mm_set1_ps(triangle->z[1] * triangle->inverse_area);
+			__m128 z2 = _mm_set1_ps(triangle->z[2] * triangle->inverse_area);
+
+			for (int y = min_y; y <= max_y; y++) {
+				float pixel_y = y + 0.5f;
+				__m128 edge_row[3];
+
+				for (int k = 0; k < 3; k++) {
+					edge_row[k] = _mm_set1_ps(triangle->edge_b[k] * pixel_y + triangle->edge_c[k]);
+				}
+
+				uint32_t* color_row = &color_buffer[y * pitch];
+				float* depth_row = &depth_buffer[y * pitch];
+
+				for (int x = min_x; x <= max_x; x += 4) {
+					__m128 pixel_x = _mm_add_ps(_mm_set1_ps((float) x), lane_offset);
+					__m128 edge[3], inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+					for (int k = 0; k < 3; k++) {
+						edge[k] = _mm_add_ps(_mm_mul_ps(edge_a[k], pixel_x), edge_row[k]);
+
+						// Owned edges include zero, the others don't.
+						__m128 covered = _mm_or_ps(_mm_and_ps(owner[k], _mm_cmpge_ps(edge[k], zero)), _mm_andnot_ps(owner[k], _mm_cmpgt_ps(edge[k], zero)));
+						inside = _mm_and_ps(inside, covered);
+					}
+
+					if (!_mm_movemask_ps(inside)) continue;
+
+					__m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edge[0], z0), _mm_mul_ps(edge[1], z1)), _mm_mul_ps(edge[2], z2));
+					__m128 old_depth = _mm_loadu_ps(&depth_row[x]);
+
+					__m128 write = _mm_and_ps(inside, _mm_cmplt_ps(depth, old_depth));
+					if (!_mm_movemask_ps(write)) continue;
+
+					_mm_storeu_ps(&depth_row[x], _mm_or_ps(_mm_and_ps(write, depth), _mm_andnot_ps(write, old_depth)));
+
+					__m128i write_mask = _mm_castps_si128(write);
+					__m128i old_color = _mm_loadu_si128((__m128i*) &color_row[x]);
+					_mm_storeu_si128((__m128i*) &color_row[x], _mm_or_si128(_mm_and_si128(write_mask, color), _mm_andnot_si128(write_mask, old_color)));
+				}
+			}
+#else
+			// Scalar fallback, same math one pixel at a time.
+
+			for (int y = min_y; y <= max_y; y++) {
+				float pixel_y = y + 0.5f;
+				float edge_row[3];
+
+				for (int k = 0; k < 3; k++) edge_row[k] = triangle->edge_b[k] * pixel_y + triangle->edge_c[k];
+
+				for (int x = min_x; x < min_x + ((max_x - min_x) / 4 + 1) * 4; x++) {
+					float pixel_x = x + 0.5f;
+					float edge[3];
+					bool inside = true;
+
+					for (int k = 0; k < 3; k++) {
+						edge[k] = triangle->edge_a[k] * pixel_x + edge_row[k];
+						inside &= triangle->edge_owner[k] ? edge[k] >= 0.0f : edge[k] > 0.0f;
+					}
+
+					if (!inside) continue;
+
+					float depth = edge[0] * (triangle->z[0] * triangle->inverse_area) + edge[1] * (triangle->z[1] * triangle->inverse_area) + edge[2] * (triangle->z[2] * triangle->inverse_area);
+
+					if (depth < depth_buffer[y * pitch + x]) {
+						depth_buffer[y * pitch + x] = depth;
+						color_buffer[y * pitch + x] = triangle->color;
+					}
+				}
+			}
+#endif
+		}
+	}
+}
+
+uint32_t* SoftwareRenderBackend::GetColorBuffer(void) {
+	return color_buffer;
+}
+
+int SoftwareRenderBackend::GetWidth(void) {
+	return width;
+}
+
+int SoftwareRenderBackend::GetHeight(void) {
+	return height;
+}
+
+int SoftwareRenderBackend::GetPitch(void) {
+	return pitch;
+}
+
+int SoftwareRenderBackend::GetThreadCount(void) {
+	return thread_count;
+}
+
+bool SoftwareRenderBackend::WritePPM(const char* path) {
+	FILE* file = fopen(path, "wb");
+
+	if (!file) {
+		printf("[SoftwareRenderBackend::WritePPM] Failed to open %s for writing!\n", path);
+		return false;
+	}
+
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			uint32_t pixel = color_buffer[y * pitch + x];
+			unsigned char rgb[3] = { (unsigned char) (pixel & 0xFF), (unsigned char) ((pixel >> 8) & 0xFF), (unsigned char) ((pixel >> 16) & 0xFF) };
+			fwrite(rgb, 1, 3, file);
+		}
+	}
+
+	fclose(file);
+	return true;
+}
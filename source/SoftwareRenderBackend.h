@@ -0,0 +1,93 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include "MemoryTracker.h"
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef SOFTWARE_RENDER_TILE_SIZE
+#define SOFTWARE_RENDER_TILE_SIZE 64
+#endif
+
+// Rasterizes DrawLists on the CPU into an in-memory framebuffer, for machines without a GPU.
+// Draw() runs two parallel passes. First every thread transforms, clips and culls its slice of the triangles and bins them into screen tiles.
+// Then the threads take whole tiles and fill the binned triangles four pixels at a time with SSE edge functions and a depth test.
+// Each tile is cleared by the first tile pass of the frame, then replays its bins in submission order, so the image doesn't depend on the thread count.
+// The worker threads live as long as the backend and the bins keep their capacity, so a steady stream of frames doesn't allocate.
+
+// Pixels are stored as 0xAABBGGRR with row 0 at the top. Rows are GetPitch() pixels apart.
+
+class SoftwareRenderBackend : public RenderBackend {
+public:
+	SoftwareRenderBackend(int thread_count = 0); // 0 uses one thread per hardware thread.
+	~SoftwareRenderBackend(void);
+
+	void Begin(RenderView* view);
+	void Draw(DrawList* source);
+	void End(void);
+
+	uint32_t* GetColorBuffer(void);
+	int GetWidth(void);
+	int GetHeight(void);
+	int GetPitch(void);
+	int GetThreadCount(void);
+	bool WritePPM(const char* path);
+private:
+	struct ScreenTriangle {
+		float edge_a[3], edge_b[3], edge_c[3]; // Edge k is opposite vertex k : a * x + b * y + c is positive inside.
+		bool edge_owner[3]; // Which of two triangles sharing an edge gets the pixels exactly on it.
+		float z[3];
+		float inverse_area;
+		uint32_t color;
+		int min_x, min_y, max_x, max_y;
+	};
+
+	typedef std::vector<int, TaggedAllocator<int, MemoryTracker::Caches> > TileBin;
+
+	struct TriangleBin {
+		std::vector<ScreenTriangle, TaggedAllocator<ScreenTriangle, MemoryTracker::Caches> > triangles;
+		std::vector<TileBin, TaggedAllocator<TileBin, MemoryTracker::Caches> > tiles; // Indices into triangles, per screen tile.
+	};
+
+	enum WorkerPhase {
+		SetupPhase,
+		RasterizePhase,
+	};
+
+	void Resize(int width, int height);
+	void SetupTriangles(DrawList* source, int thread);
+	void EmitTriangle(TriangleBin* bin, float* a, float* b, float* c, uint32_t color);
+	void RasterizeTiles(void);
+	void RasterizeTile(int tile);
+	void RunPhase(WorkerPhase phase, int thread);
+	void RunWorkers(WorkerPhase phase);
+	void WorkerLoop(int thread);
+
+	int width, height, pitch;
+	int tiles_x, tiles_y;
+	uint32_t* color_buffer;
+	float* depth_buffer;
+
+	float view_projection[16]; // Column-major, like OpenGL.
+	uint32_t clear_color;
+	bool clear_pending; // Set by Begin(), applied per tile by the next tile pass.
+
+	int thread_count;
+	std::vector<TriangleBin, TaggedAllocator<TriangleBin, MemoryTracker::Caches> > bins; // One per thread.
+	std::atomic<int> next_tile;
+
+	// Worker 0 is whoever calls Draw(), the others wait on worker_start for the next phase.
+	std::vector<std::thread> workers;
+	std::mutex worker_mutex;
+	std::condition_variable worker_start, worker_done;
+	unsigned int worker_generation;
+	int workers_pending;
+	WorkerPhase worker_phase;
+	DrawList* worker_source;
+	bool workers_exit;
+};
@@ -1,10 +1,12 @@
 #include "Voxel.h"
+#include "DrawList.h"
+#include "MemoryTracker.h"
 
-#include <GL/glew.h>
 #include <cstdlib>
 #include <cstring>
 #include <cstdio>
 #include <cmath>
+#include <new>
 
 Voxel::Voxel(float color_r, float color_g, float color_b, bool* occlude_buffer, Voxel::VoxelShape mode) {
 	if (occlude_buffer) {
@@ -20,6 +22,30 @@ Voxel::Voxel(float color_r, float color_g, float color_b, bool* occlude_buffer,
 Voxel::~Voxel(void) {
 }
 
+void* Voxel::operator new(size_t size) {
+	void* pointer = MemoryTracker::Allocate(size, MemoryTracker::VoxelPayloads);
+	if (!pointer) throw std::bad_alloc();
+
+	return pointer;
+}
+
+void Voxel::operator delete(void* pointer) {
+	MemoryTracker::Free(pointer);
+}
+
+static float FaceNoise(int x, int y, int z, int face) {
+	// Each face gets a small brightness offset so flat walls don't look like one solid slab.
+	// Hashing the position instead of calling rand() keeps equal voxels identical in memory.
+
+	unsigned int hash = (unsigned int) x * 73856093u ^ (unsigned int) y * 19349663u ^ (unsigned int) z * 83492791u ^ (unsigned int) face * 2654435761u;
+	hash ^= hash >> 13;
+	hash *= 0x5bd1e995u;
+	hash ^= hash >> 15;
+
+	float noise_magnitude = 0.1f;
+	return (((hash % 1000) / 1000.0f) * noise_magnitude) - noise_magnitude / 2.0f;
+}
+
 Voxel::VoxelShape Voxel::GetDrawMode(void) {
 	return draw_mode;
 }
@@ -31,6 +57,13 @@ bool Voxel::IsFullyOccluded(void) {
 	return flag;
 }
 
+bool Voxel::Matches(Voxel* other) {
+	if (raw_r != other->raw_r || raw_g != other->raw_g || raw_b != other->raw_b) return false;
+	if (draw_mode != other->draw_mode) return false;
+
+	return memcmp(occlude, other->occlude, sizeof(bool) * 6) == 0;
+}
+
 void Voxel::SetDrawMode(Voxel::VoxelShape mode) {
 	this->draw_mode = mode;
 }
@@ -45,14 +78,6 @@ void Voxel::SetColor(float r, float g, float b) {
 	raw_r = r;
 	raw_g = g;
 	raw_b = b;
-
-	for (int i = 0; i < 6; i++) {
-		float noise_magnitude = 0.1f;
-		float noise_offset = (((rand() % 1000) / 1000.0f) * noise_magnitude) - noise_magnitude / 2.0f;
-		this->r[i] = r + noise_offset;
-		this->g[i] = g + noise_offset;
-		this->b[i] = b + noise_offset;
-	}
 }
 
 void Voxel::GetColor(float* r, float* g, float* b) {
@@ -61,7 +86,7 @@ void Voxel::GetColor(float* r, float* g, float* b) {
 	*b = this->raw_b;
 }
 
-void Voxel::Draw(int x, int y, int z) {
+void Voxel::Draw(int x, int y, int z, DrawList* target) {
 	// I use this function all too often for voxel debugging.
 	// printf("[Voxel] Drawing at %d, %d, %d\n", x, y, z);
 
@@ -69,6 +94,7 @@ void Voxel::Draw(int x, int y, int z) {
 	// There aren't going to be too many voxels present in this program, so we don't have to worry about that immediately.
 
 	// To completely draw the voxel, we have to wind the cube. Ugh.
+	// The triangles go to the target DrawList instead of straight to OpenGL.
 	// x, y represents the CENTER of the voxel being drawn.
 	// The dimensions should all be 1, centered on the origin.
 	bool occlude_flag = true;
@@ -76,109 +102,113 @@ void Voxel::Draw(int x, int y, int z) {
 
 	if (occlude_flag) return;
 
+	float r[6], g[6], b[6];
+
+	for (int i = 0; i < 6; i++) {
+		float noise_offset = FaceNoise(x, y, z, i);
+		r[i] = raw_r + noise_offset;
+		g[i] = raw_g + noise_offset;
+		b[i] = raw_b + noise_offset;
+	}
+
 	switch (draw_mode) {
 	case VoxelShape::Cuboid:
-		glMatrixMode(GL_MODELVIEW);
-		glBegin(GL_TRIANGLES);
-			// Front face.
-			if (!occlude[0]) {
-				glColor4f(r[0], g[0], b[0], 1.0f);
-				glVertex3f(x - 0.5f, y - 0.5f, z + 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z + 0.5f);
-				glVertex3f(x - 0.5f, y + 0.5f, z + 0.5f);
-				glVertex3f(x - 0.5f, y + 0.5f, z + 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z + 0.5f);
-				glVertex3f(x + 0.5f, y + 0.5f, z + 0.5f);
-			}
-
-			// Back face.
-			if (!occlude[1]) {
-				glColor4f(r[1], g[1], b[1], 1.0f);
-				glVertex3f(x - 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x - 0.5f, y + 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x - 0.5f, y + 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y + 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z - 0.5f);
-			}
-
-			// Top face.
-			if (!occlude[2]) {
-				glColor4f(r[2], g[2], b[2], 1.0f);
-				glVertex3f(x - 0.5f, y + 0.5f, z + 0.5f);
-				glVertex3f(x + 0.5f, y + 0.5f, z + 0.5f);
-				glVertex3f(x - 0.5f, y + 0.5f, z - 0.5f);
-				glVertex3f(x - 0.5f, y + 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y + 0.5f, z + 0.5f);
-				glVertex3f(x + 0.5f, y + 0.5f, z - 0.5f);
-			}
-
-			// Bottom face.
-			if (!occlude[3]) {
-				glColor4f(r[3], g[3], b[3], 1.0f);
-				glVertex3f(x - 0.5f, y - 0.5f, z + 0.5f);
-				glVertex3f(x - 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z + 0.5f);
-				glVertex3f(x - 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z + 0.5f);
-			}
-
-			// Right face.
-			if (!occlude[4]) {
-				glColor4f(r[4], g[4], b[4], 1.0f);
-				glVertex3f(x + 0.5f, y - 0.5f, z + 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y + 0.5f, z + 0.5f);
-				glVertex3f(x + 0.5f, y + 0.5f, z + 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y + 0.5f, z - 0.5f);
-			}
-
-			// Left face.
-			if (!occlude[5]) {
-				glColor4f(r[5], g[5], b[5], 1.0f);
-				glVertex3f(x - 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x - 0.5f, y - 0.5f, z + 0.5f);
-				glVertex3f(x - 0.5f, y + 0.5f, z - 0.5f);
-				glVertex3f(x - 0.5f, y + 0.5f, z - 0.5f);
-				glVertex3f(x - 0.5f, y - 0.5f, z + 0.5f);
-				glVertex3f(x - 0.5f, y + 0.5f, z + 0.5f);
-			}
-		glEnd();
+		// Front face.
+		if (!occlude[0]) {
+			target->SetColor(r[0], g[0], b[0]);
+			target->AddVertex(x - 0.5f, y - 0.5f, z + 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z + 0.5f);
+			target->AddVertex(x - 0.5f, y + 0.5f, z + 0.5f);
+			target->AddVertex(x - 0.5f, y + 0.5f, z + 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z + 0.5f);
+			target->AddVertex(x + 0.5f, y + 0.5f, z + 0.5f);
+		}
+
+		// Back face.
+		if (!occlude[1]) {
+			target->SetColor(r[1], g[1], b[1]);
+			target->AddVertex(x - 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x - 0.5f, y + 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x - 0.5f, y + 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y + 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z - 0.5f);
+		}
+
+		// Top face.
+		if (!occlude[2]) {
+			target->SetColor(r[2], g[2], b[2]);
+			target->AddVertex(x - 0.5f, y + 0.5f, z + 0.5f);
+			target->AddVertex(x + 0.5f, y + 0.5f, z + 0.5f);
+			target->AddVertex(x - 0.5f, y + 0.5f, z - 0.5f);
+			target->AddVertex(x - 0.5f, y + 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y + 0.5f, z + 0.5f);
+			target->AddVertex(x + 0.5f, y + 0.5f, z - 0.5f);
+		}
+
+		// Bottom face.
+		if (!occlude[3]) {
+			target->SetColor(r[3], g[3], b[3]);
+			target->AddVertex(x - 0.5f, y - 0.5f, z + 0.5f);
+			target->AddVertex(x - 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z + 0.5f);
+			target->AddVertex(x - 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z + 0.5f);
+		}
+
+		// Right face.
+		if (!occlude[4]) {
+			target->SetColor(r[4], g[4], b[4]);
+			target->AddVertex(x + 0.5f, y - 0.5f, z + 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y + 0.5f, z + 0.5f);
+			target->AddVertex(x + 0.5f, y + 0.5f, z + 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y + 0.5f, z - 0.5f);
+		}
+
+		// Left face.
+		if (!occlude[5]) {
+			target->SetColor(r[5], g[5], b[5]);
+			target->AddVertex(x - 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x - 0.5f, y - 0.5f, z + 0.5f);
+			target->AddVertex(x - 0.5f, y + 0.5f, z - 0.5f);
+			target->AddVertex(x - 0.5f, y + 0.5f, z - 0.5f);
+			target->AddVertex(x - 0.5f, y - 0.5f, z + 0.5f);
+			target->AddVertex(x - 0.5f, y + 0.5f, z + 0.5f);
+		}
 		break;
 	case VoxelShape::Pyramid:
-		glBegin(GL_TRIANGLES);
-			if (!occlude[3]) {
-				glColor4f(r[0], g[0], b[0], 1.0f);
-				glVertex3f(x - 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x - 0.5f, y - 0.5f, z + 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z - 0.5f);
-				glVertex3f(x + 0.5f, y - 0.5f, z + 0.5f);
-				glVertex3f(x - 0.5f, y - 0.5f, z + 0.5f);
-			}
-
-			glColor4f(r[1], g[1], b[1], 1.0f);
-			glVertex3f(x - 0.5f, y - 0.5f, z + 0.5f);
-			glVertex3f(x + 0.5f, y - 0.5f, z + 0.5f);
-			glVertex3f(x, y + 0.5f, z);
-
-			glColor4f(r[2], g[2], b[2], 1.0f);
-			glVertex3f(x - 0.5f, y - 0.5f, z - 0.5f);
-			glVertex3f(x - 0.5f, y - 0.5f, z + 0.5f);
-			glVertex3f(x, y + 0.5f, z);
-
-			glColor4f(r[3], g[3], b[3], 1.0f);
-			glVertex3f(x + 0.5f, y - 0.5f, z + 0.5f);
-			glVertex3f(x + 0.5f, y - 0.5f, z - 0.5f);
-			glVertex3f(x, y + 0.5f, z);
-
-			glColor4f(r[4], g[4], b[4], 1.0f);
-			glVertex3f(x + 0.5f, y - 0.5f, z - 0.5f);
-			glVertex3f(x - 0.5f, y - 0.5f, z - 0.5f);
-			glVertex3f(x, y + 0.5f, z);
-		glEnd();
+		if (!occlude[3]) {
+			target->SetColor(r[0], g[0], b[0]);
+			target->AddVertex(x - 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x - 0.5f, y - 0.5f, z + 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z - 0.5f);
+			target->AddVertex(x + 0.5f, y - 0.5f, z + 0.5f);
+			target->AddVertex(x - 0.5f, y - 0.5f, z + 0.5f);
+		}
+
+		target->SetColor(r[1], g[1], b[1]);
+		target->AddVertex(x - 0.5f, y - 0.5f, z + 0.5f);
+		target->AddVertex(x + 0.5f, y - 0.5f, z + 0.5f);
+		target->AddVertex(x, y + 0.5f, z);
+
+		target->SetColor(r[2], g[2], b[2]);
+		target->AddVertex(x - 0.5f, y - 0.5f, z - 0.5f);
+		target->AddVertex(x - 0.5f, y - 0.5f, z + 0.5f);
+		target->AddVertex(x, y + 0.5f, z);
+
+		target->SetColor(r[3], g[3], b[3]);
+		target->AddVertex(x + 0.5f, y - 0.5f, z + 0.5f);
+		target->AddVertex(x + 0.5f, y - 0.5f, z - 0.5f);
+		target->AddVertex(x, y + 0.5f, z);
+
+		target->SetColor(r[4], g[4], b[4]);
+		target->AddVertex(x + 0.5f, y - 0.5f, z - 0.5f);
+		target->AddVertex(x - 0.5f, y - 0.5f, z - 0.5f);
+		target->AddVertex(x, y + 0.5f, z);
 		break;
 	}
 }
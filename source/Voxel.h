@@ -1,11 +1,18 @@
 #pragma once
 
+#include <cstddef>
+
 // This isn't exactly an engine, but we do need a class to contain and draw voxels.
 // To preserve codespace, the Voxel class will have its own texture caching system.
 
 // Make sure to call Voxel::FlushTextureCache() to flush the allocated texture cache!
 // This should be called during program resource deallocation.
 
+// Voxels are plain values : two voxels with the same color, shape and occlusion are interchangeable.
+// The per-face color noise is derived from the draw position, so the VoxelGrid can share equal voxels between cells.
+
+class DrawList;
+
 class Voxel {
 public:
 	enum VoxelShape {
@@ -16,17 +23,21 @@ public:
 	Voxel(float r, float g, float b, bool* occlude, VoxelShape mode = VoxelShape::Cuboid);
 	~Voxel(void);
 
+	// Voxels are counted as MemoryTracker::VoxelPayloads.
+	static void* operator new(size_t size);
+	static void operator delete(void* pointer);
+
 	void SetColor(float r, float g, float b);
 	void GetColor(float* r, float* g, float* b);
-	void Draw(int x, int y, int z);
+	void Draw(int x, int y, int z, DrawList* target);
 	void SetOcclude(float* occlude);
 	void SetDrawMode(VoxelShape mode);
 	bool IsFullyOccluded(void);
+	bool Matches(Voxel* other);
 	VoxelShape GetDrawMode(void);
 private:
 	bool occlude[6];
-	float r[6], g[6], b[6]; // We exclude the transparency channel from the color. Binary-space tree partitioning and quadtree ordering is out of the scope of this program.
-	float raw_r, raw_g, raw_b;
+	float raw_r, raw_g, raw_b; // We exclude the transparency channel from the color. Binary-space tree partitioning and quadtree ordering is out of the scope of this program.
 
 	VoxelShape draw_mode;
 	// Voxels do not need to and will not keep track of their position.
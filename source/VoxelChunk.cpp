@@ -0,0 +1,406 @@
+#include "VoxelChunk.h"
+#include "MemoryTracker.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+// Run ends are stored as unsigned shorts, so they must be able to reach the end of the chunk.
+static_assert(VOXEL_CHUNK_VOLUME <= 65535, "VOXEL_CHUNK_SIZE is too large for the compressed chunk format.");
+
+static int PackedWords(int bits) {
+	return (VOXEL_CHUNK_VOLUME * bits + 63) / 64;
+}
+
+static int MinimumBits(int palette_size) {
+	int bits = 1;
+	while ((1 << bits) < palette_size) bits++;
+
+	return bits;
+}
+
+static int ReadPacked(uint64_t* buffer, int bits, int index) {
+	int bit = index * bits;
+	int word = bit >> 6, offset = bit & 63;
+
+	uint64_t value = buffer[word] >> offset;
+	if (offset + bits > 64) value |= buffer[word + 1] << (64 - offset); // The index straddles two words.
+
+	return (int) (value & ((1ull << bits) - 1));
+}
+
+static void WritePacked(uint64_t* buffer, int bits, int index, int value) {
+	int bit = index * bits;
+	int word = bit >> 6, offset = bit & 63;
+	uint64_t mask = (1ull << bits) - 1;
+
+	buffer[word] = (buffer[word] & ~(mask << offset)) | ((uint64_t) value << offset);
+
+	if (offset + bits > 64) {
+		int spill = 64 - offset;
+		buffer[word + 1] = (buffer[word + 1] & ~(mask >> spill)) | ((uint64_t) value >> spill);
+	}
+}
+
+static void DrawCell(Voxel* voxel, int origin_x, int origin_y, int origin_z, int index, DrawList* target) {
+	voxel->Draw(origin_x + index / (VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE), origin_y + (index / VOXEL_CHUNK_SIZE) % VOXEL_CHUNK_SIZE, origin_z + index % VOXEL_CHUNK_SIZE, target);
+}
+
+VoxelChunk::VoxelChunk(void) {
+	// Every chunk starts out as a collapsed chunk of empty cells, which costs no allocations at all.
+
+	uniform_voxel = NULL;
+
+	palette = NULL;
+	palette_refs = NULL;
+	palette_size = 0;
+	palette_capacity = 0;
+
+	index_bits = 0;
+	index_buffer = NULL;
+
+	run_buffer = NULL;
+	run_count = 0;
+	compacted = false;
+
+	last_access = 0;
+}
+
+void* VoxelChunk::operator new[](size_t size) {
+	void* pointer = MemoryTracker::Allocate(size, MemoryTracker::GridTables);
+	if (!pointer) throw std::bad_alloc();
+
+	return pointer;
+}
+
+void VoxelChunk::operator delete[](void* pointer) {
+	MemoryTracker::Free(pointer);
+}
+
+VoxelChunk::~VoxelChunk(void) {
+	if (palette) {
+		for (int i = 0; i < palette_size; i++) {
+			delete palette[i];
+		}
+
+		MemoryTracker::Free(palette);
+		MemoryTracker::Free(palette_refs);
+	} else {
+		delete uniform_voxel;
+	}
+
+	MemoryTracker::Free(index_buffer);
+	MemoryTracker::Free(run_buffer);
+}
+
+void VoxelChunk::SetVoxel(int index, Voxel* target) {
+	Decompress();
+	compacted = false;
+
+	if (!palette) {
+		if (target == uniform_voxel) return;
+
+		if (target && uniform_voxel && target->Matches(uniform_voxel)) {
+			delete target;
+			return;
+		}
+
+		Expand();
+	}
+
+	int entry = FindPaletteEntry(target);
+
+	if (entry < 0) {
+		entry = AddPaletteEntry(target);
+	} else if (palette[entry] != target) {
+		delete target; // An equal voxel is already in the palette.
+	}
+
+	int previous = ReadPacked(index_buffer, index_bits, index);
+	if (previous == entry) return;
+
+	WritePacked(index_buffer, index_bits, index, entry);
+	palette_refs[entry]++;
+
+	if (--palette_refs[previous] == 0 && previous != 0) {
+		delete palette[previous];
+		palette[previous] = NULL;
+	}
+
+	if (palette_refs[entry] == VOXEL_CHUNK_VOLUME) {
+		Collapse(entry);
+	}
+}
+
+Voxel* VoxelChunk::GetVoxel(int index) {
+	if (!palette) return uniform_voxel;
+	if (!run_buffer) return palette[ReadPacked(index_buffer, index_bits, index)];
+
+	// Reads binary search the runs in place, so a compressed chunk stays compressed.
+
+	int first = 0, last = run_count - 1;
+
+	while (first < last) {
+		int middle = (first + last) / 2;
+
+		if (run_buffer[middle * 2] > index) {
+			last = middle;
+		} else {
+			first = middle + 1;
+		}
+	}
+
+	return palette[run_buffer[first * 2 + 1]];
+}
+
+void VoxelChunk::DrawAll(int origin_x, int origin_y, int origin_z, DrawList* target) {
+	// Drawing walks whichever form the chunk is in, so cold chunks stay compressed.
+
+	if (!palette) {
+		if (!uniform_voxel) return;
+
+		for (int i = 0; i < VOXEL_CHUNK_VOLUME; i++) {
+			DrawCell(uniform_voxel, origin_x, origin_y, origin_z, i, target);
+		}
+
+		return;
+	}
+
+	if (run_buffer) {
+		int cell = 0;
+
+		for (int run = 0; run < run_count; run++) {
+			Voxel* voxel = palette[run_buffer[run * 2 + 1]];
+
+			for (; cell < run_buffer[run * 2]; cell++) {
+				if (voxel) DrawCell(voxel, origin_x, origin_y, origin_z, cell, target);
+			}
+		}
+
+		return;
+	}
+
+	for (int i = 0; i < VOXEL_CHUNK_VOLUME; i++) {
+		Voxel* voxel = palette[ReadPacked(index_buffer, index_bits, i)];
+		if (voxel) DrawCell(voxel, origin_x, origin_y, origin_z, i, target);
+	}
+}
+
+void VoxelChunk::Compress(void) {
+	if (!palette || compacted) return;
+
+	compacted = true;
+
+	// First, drop the freed palette entries so the indices fit in as few bits as possible.
+	// A palette holds at most one entry per cell, the empty entry, and one new entry added before SetVoxel() frees the old one.
+	// That bounds the remap table, so it lives on the stack instead of the heap.
+
+	unsigned short remap[VOXEL_CHUNK_VOLUME + 2];
+	int count = 0;
+
+	for (int i = 0; i < palette_size; i++) {
+		if (i != 0 && !palette[i]) continue;
+
+		remap[i] = count;
+		palette[count] = palette[i];
+		palette_refs[count] = palette_refs[i];
+		count++;
+	}
+
+	if (count != palette_size) {
+		int bits = MinimumBits(count);
+
+		uint64_t* buffer = MemoryTracker::AllocateArray<uint64_t>(PackedWords(bits), MemoryTracker::GridTables);
+		memset(buffer, 0, sizeof(uint64_t) * PackedWords(bits));
+
+		for (int i = 0; i < VOXEL_CHUNK_VOLUME; i++) {
+			WritePacked(buffer, bits, i, remap[ReadPacked(index_buffer, index_bits, i)]);
+		}
+
+		MemoryTracker::Free(index_buffer);
+		index_buffer = buffer;
+		index_bits = bits;
+		palette_size = count;
+	}
+
+	// Then we encode the indices as runs, but only if that actually beats the packed form.
+
+	int runs = 1;
+	int current = ReadPacked(index_buffer, index_bits, 0);
+
+	for (int i = 1; i < VOXEL_CHUNK_VOLUME; i++) {
+		int value = ReadPacked(index_buffer, index_bits, i);
+
+		if (value != current) {
+			current = value;
+			runs++;
+		}
+	}
+
+	if (runs * 2 * sizeof(unsigned short) >= PackedWords(index_bits) * sizeof(uint64_t)) return;
+
+	run_buffer = MemoryTracker::AllocateArray<unsigned short>(runs * 2, MemoryTracker::GridTables);
+	run_count = 0;
+
+	for (int i = 0; i < VOXEL_CHUNK_VOLUME; i++) {
+		int value = ReadPacked(index_buffer, index_bits, i);
+
+		if (run_count && run_buffer[(run_count - 1) * 2 + 1] == value) {
+			run_buffer[(run_count - 1) * 2] = i + 1;
+		} else {
+			run_buffer[run_count * 2] = i + 1;
+			run_buffer[run_count * 2 + 1] = value;
+			run_count++;
+		}
+	}
+
+	MemoryTracker::Free(index_buffer);
+	index_buffer = NULL;
+}
+
+bool VoxelChunk::IsCompressed(void) {
+	return run_buffer != NULL;
+}
+
+bool VoxelChunk::IsCompacted(void) {
+	return compacted;
+}
+
+bool VoxelChunk::IsUniform(void) {
+	return palette == NULL;
+}
+
+void VoxelChunk::Touch(unsigned int tick) {
+	last_access = tick;
+}
+
+unsigned int VoxelChunk::GetLastAccess(void) {
+	return last_access;
+}
+
+void VoxelChunk::Expand(void) {
+	// Turn a collapsed chunk into a palette chunk with one-bit indices.
+
+	palette_capacity = 4;
+	palette = MemoryTracker::AllocateArray<Voxel*>(palette_capacity, MemoryTracker::GridTables);
+	palette_refs = MemoryTracker::AllocateArray<unsigned int>(palette_capacity, MemoryTracker::GridTables);
+
+	palette[0] = NULL;
+	palette_refs[0] = 0;
+	palette_size = 1;
+
+	index_bits = 1;
+	index_buffer = MemoryTracker::AllocateArray<uint64_t>(PackedWords(index_bits), MemoryTracker::GridTables);
+
+	if (uniform_voxel) {
+		palette[1] = uniform_voxel;
+		palette_refs[1] = VOXEL_CHUNK_VOLUME;
+		palette_size = 2;
+
+		memset(index_buffer, 0xFF, sizeof(uint64_t) * PackedWords(index_bits));
+	} else {
+		palette_refs[0] = VOXEL_CHUNK_VOLUME;
+
+		memset(index_buffer, 0, sizeof(uint64_t) * PackedWords(index_bits));
+	}
+
+	uniform_voxel = NULL;
+}
+
+void VoxelChunk::Collapse(int entry) {
+	// The given entry now covers every cell, so all other palette entries have already been freed.
+
+	uniform_voxel = palette[entry];
+
+	MemoryTracker::Free(palette);
+	MemoryTracker::Free(palette_refs);
+	MemoryTracker::Free(index_buffer);
+
+	palette = NULL;
+	palette_refs = NULL;
+	palette_size = 0;
+	palette_capacity = 0;
+
+	index_bits = 0;
+	index_buffer = NULL;
+}
+
+void VoxelChunk::Decompress(void) {
+	if (!run_buffer) return;
+
+	index_buffer = MemoryTracker::AllocateArray<uint64_t>(PackedWords(index_bits), MemoryTracker::GridTables);
+	memset(index_buffer, 0, sizeof(uint64_t) * PackedWords(index_bits));
+
+	int cell = 0;
+
+	for (int run = 0; run < run_count; run++) {
+		for (; cell < run_buffer[run * 2]; cell++) {
+			WritePacked(index_buffer, index_bits, cell, run_buffer[run * 2 + 1]);
+		}
+	}
+
+	MemoryTracker::Free(run_buffer);
+	run_buffer = NULL;
+	run_count = 0;
+}
+
+void VoxelChunk::Repack(int bits) {
+	uint64_t* buffer = MemoryTracker::AllocateArray<uint64_t>(PackedWords(bits), MemoryTracker::GridTables);
+	memset(buffer, 0, sizeof(uint64_t) * PackedWords(bits));
+
+	for (int i = 0; i < VOXEL_CHUNK_VOLUME; i++) {
+		WritePacked(buffer, bits, i, ReadPacked(index_buffer, index_bits, i));
+	}
+
+	MemoryTracker::Free(index_buffer);
+	index_buffer = buffer;
+	index_bits = bits;
+}
+
+int VoxelChunk::FindPaletteEntry(Voxel* target) {
+	if (!target) return 0;
+
+	for (int i = 1; i < palette_size; i++) {
+		if (palette[i] && (palette[i] == target || palette[i]->Matches(target))) return i;
+	}
+
+	return -1;
+}
+
+int VoxelChunk::AddPaletteEntry(Voxel* target) {
+	// Reuse a freed entry before growing the palette.
+
+	for (int i = 1; i < palette_size; i++) {
+		if (!palette[i]) {
+			palette[i] = target;
+			return i;
+		}
+	}
+
+	if (palette_size == palette_capacity) {
+		int capacity = palette_capacity * 2;
+
+		Voxel** new_palette = MemoryTracker::AllocateArray<Voxel*>(capacity, MemoryTracker::GridTables);
+		unsigned int* new_refs = MemoryTracker::AllocateArray<unsigned int>(capacity, MemoryTracker::GridTables);
+
+		memcpy(new_palette, palette, sizeof(Voxel*) * palette_size);
+		memcpy(new_refs, palette_refs, sizeof(unsigned int) * palette_size);
+
+		MemoryTracker::Free(palette);
+		MemoryTracker::Free(palette_refs);
+
+		palette = new_palette;
+		palette_refs = new_refs;
+		palette_capacity = capacity;
+	}
+
+	if (palette_size >= (1 << index_bits)) {
+		Repack(index_bits + 1);
+	}
+
+	palette[palette_size] = target;
+	palette_refs[palette_size] = 0;
+
+	return palette_size++;
+}
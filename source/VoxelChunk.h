@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Voxel.h"
+#include "DrawList.h"
+
+#include <stdint.h>
+#include <cstddef>
+
+#ifndef VOXEL_CHUNK_SIZE
+#define VOXEL_CHUNK_SIZE 16
+#endif
+
+#define VOXEL_CHUNK_VOLUME (VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE)
+
+// Compress() allocates at most this many blocks : a narrower index buffer and the run buffer.
+#define VOXEL_CHUNK_COMPRESS_ALLOCATIONS 2
+
+// A VoxelChunk stores a cube of VOXEL_CHUNK_SIZE^3 voxel handles, indexed from 0 to VOXEL_CHUNK_VOLUME - 1.
+// A chunk made of one voxel (or of nothing at all) collapses to a single handle.
+// A mixed chunk keeps a local palette of unique voxels, and every cell stores a bit-packed palette index of the minimum width.
+// Compress() squeezes a mixed chunk further into runs of palette indices, when that beats the packed form.
+// GetVoxel() reads the runs in place, and only SetVoxel() unpacks the chunk again.
+
+// Equal voxels share a single palette entry, so the chunk takes ownership of whatever is passed to SetVoxel() and may delete it on the spot.
+// Handles returned by GetVoxel() are shared between cells and must be treated as read-only.
+
+class VoxelChunk {
+public:
+	VoxelChunk(void);
+	~VoxelChunk(void);
+
+	// Chunk tables and everything inside the chunks are counted as MemoryTracker::GridTables.
+	static void* operator new[](size_t size);
+	static void operator delete[](void* pointer);
+
+	void SetVoxel(int index, Voxel* target);
+	Voxel* GetVoxel(int index);
+	void DrawAll(int origin_x, int origin_y, int origin_z, DrawList* target);
+
+	void Compress(void);
+	bool IsCompressed(void);
+	bool IsCompacted(void); // Compress() has run since the last SetVoxel(), whether or not it found runs worth keeping.
+	bool IsUniform(void);
+
+	void Touch(unsigned int tick);
+	unsigned int GetLastAccess(void);
+private:
+	void Expand(void);
+	void Collapse(int entry);
+	void Decompress(void);
+	void Repack(int bits);
+	int FindPaletteEntry(Voxel* target);
+	int AddPaletteEntry(Voxel* target);
+
+	Voxel* uniform_voxel; // Only meaningful while palette is NULL.
+
+	Voxel** palette; // Entry 0 is always the empty cell. Freed entries are NULL with no references.
+	unsigned int* palette_refs;
+	int palette_size, palette_capacity;
+
+	int index_bits;
+	uint64_t* index_buffer;
+
+	unsigned short* run_buffer; // Compressed form : pairs of (cell after the run, palette index), so reads can binary search.
+	int run_count;
+	bool compacted;
+
+	unsigned int last_access;
+};
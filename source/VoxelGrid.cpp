@@ -1,48 +1,33 @@
 #include "VoxelGrid.h"
+#include "MemoryTracker.h"
 
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
 
 VoxelGrid::VoxelGrid(void) {
-	// Allocate the 3-dimensional handle buffer.
+	// Chunks start out collapsed and empty, so this is the only allocation until voxels are placed.
 
-	voxel_buffer = new Voxel***[VOXEL_GRID_SIZE_X];
-
-	for (int x = 0; x < VOXEL_GRID_SIZE_X; x++) {
-		voxel_buffer[x] = NULL;
-		voxel_buffer[x] = new Voxel**[VOXEL_GRID_SIZE_Y];
-
-		for (int y = 0; y < VOXEL_GRID_SIZE_Y; y++) {
-			voxel_buffer[x][y] = new Voxel*[VOXEL_GRID_SIZE_Z];
-
-			for (int z = 0; z < VOXEL_GRID_SIZE_Z; z++) {
-				voxel_buffer[x][y][z] = NULL;
-			}
-		}
-	}
+	chunk_buffer = new VoxelChunk[VOXEL_GRID_CHUNKS_X * VOXEL_GRID_CHUNKS_Y * VOXEL_GRID_CHUNKS_Z];
+	access_tick = 0;
+	revision = 1; // A fresh DrawList has revision 0, so it always starts out stale.
 }
 
 VoxelGrid::~VoxelGrid(void) {
-	// Progressive deallocation of an enormous buffer.
+	delete[] chunk_buffer;
+	chunk_buffer = NULL;
+}
 
-	for (int x = 0; x < VOXEL_GRID_SIZE_X; x++) {
-		for (int y = 0; y < VOXEL_GRID_SIZE_Y; y++) {
-			for (int z = 0; z < VOXEL_GRID_SIZE_Z; z++) {
-				delete voxel_buffer[x][y][z];
-				voxel_buffer[x][y][z] = NULL;
-			}
+VoxelChunk* VoxelGrid::FindChunk(int index_x, int index_y, int index_z, int* cell) {
+	// Converts array indices to a chunk and the cell index inside of it.
 
-			delete[] voxel_buffer[x][y];
-			voxel_buffer[x][y] = NULL;
-		}
+	int chunk_x = index_x / VOXEL_CHUNK_SIZE;
+	int chunk_y = index_y / VOXEL_CHUNK_SIZE;
+	int chunk_z = index_z / VOXEL_CHUNK_SIZE;
 
-		delete[] voxel_buffer[x];
-		voxel_buffer[x] = NULL;
-	}
+	*cell = ((index_x % VOXEL_CHUNK_SIZE) * VOXEL_CHUNK_SIZE + index_y % VOXEL_CHUNK_SIZE) * VOXEL_CHUNK_SIZE + index_z % VOXEL_CHUNK_SIZE;
 
-	delete[] voxel_buffer;
-	voxel_buffer = NULL;
+	return &chunk_buffer[(chunk_x * VOXEL_GRID_CHUNKS_Y + chunk_y) * VOXEL_GRID_CHUNKS_Z + chunk_z];
 }
 
 bool VoxelGrid::VoxelPresent(int x, int y, int z) {
@@ -54,7 +39,8 @@ bool VoxelGrid::VoxelPresent(int x, int y, int z) {
 	if (index_y < 0 || index_y >= VOXEL_GRID_SIZE_Y) return false;
 	if (index_z < 0 || index_z >= VOXEL_GRID_SIZE_Z) return false;
 
-	return voxel_buffer[index_x][index_y][index_z] != NULL;
+	int cell = 0;
+	return FindChunk(index_x, index_y, index_z, &cell)->GetVoxel(cell) != NULL;
 }
 
 Voxel* VoxelGrid::GetVoxel(int x, int y, int z) {
@@ -77,7 +63,8 @@ Voxel* VoxelGrid::GetVoxel(int x, int y, int z) {
 		return NULL;
 	}
 
-	return voxel_buffer[index_x][index_y][index_z];
+	int cell = 0;
+	return FindChunk(index_x, index_y, index_z, &cell)->GetVoxel(cell);
 }
 
 void VoxelGrid::SetVoxel(int x, int y, int z, Voxel* target) {
@@ -102,21 +89,75 @@ void VoxelGrid::SetVoxel(int x, int y, int z, Voxel* target) {
 		return;
 	}
 
-	if (voxel_buffer[index_x][index_y][index_z]) {
-		delete voxel_buffer[index_x][index_y][index_z];
+	// The chunk takes care of deleting the voxel being replaced.
+	// Only writes mark a chunk as recently used : the collision sweep reads the whole map every frame.
+
+	int cell = 0;
+	VoxelChunk* chunk = FindChunk(index_x, index_y, index_z, &cell);
+
+	chunk->SetVoxel(cell, target);
+	chunk->Touch(access_tick);
+
+	revision++;
+}
+
+void VoxelGrid::DrawAll(RenderBackend* backend) {
+	backend->Draw(GetDrawList());
+}
+
+DrawList* VoxelGrid::GetDrawList(void) {
+	if (draw_list.GetRevision() != revision) {
+		BuildDrawList();
 	}
 
-	voxel_buffer[index_x][index_y][index_z] = target;
+	return &draw_list;
 }
 
-void VoxelGrid::DrawAll(void) {
-	for (int x = 0; x < VOXEL_GRID_SIZE_X; x++) {
-		for (int y = 0; y < VOXEL_GRID_SIZE_Y; y++) {
-			for (int z = 0; z < VOXEL_GRID_SIZE_Z; z++) {
-				if (voxel_buffer[x][y][z]) {
-					voxel_buffer[x][y][z]->Draw(x - VOXEL_GRID_SIZE_X / 2, y - VOXEL_GRID_SIZE_Y / 2, z - VOXEL_GRID_SIZE_Z / 2);
-				}
+void VoxelGrid::BuildDrawList(void) {
+	// Drawing doesn't count as an access, or no chunk would ever go cold.
+
+	draw_list.Clear();
+
+	for (int x = 0; x < VOXEL_GRID_CHUNKS_X; x++) {
+		for (int y = 0; y < VOXEL_GRID_CHUNKS_Y; y++) {
+			for (int z = 0; z < VOXEL_GRID_CHUNKS_Z; z++) {
+				VoxelChunk* chunk = &chunk_buffer[(x * VOXEL_GRID_CHUNKS_Y + y) * VOXEL_GRID_CHUNKS_Z + z];
+				chunk->DrawAll(x * VOXEL_CHUNK_SIZE - VOXEL_GRID_SIZE_X / 2, y * VOXEL_CHUNK_SIZE - VOXEL_GRID_SIZE_Y / 2, z * VOXEL_CHUNK_SIZE - VOXEL_GRID_SIZE_Z / 2, &draw_list);
 			}
 		}
 	}
+
+	draw_list.SetRevision(revision);
+}
+
+int VoxelGrid::GetCompressedChunkCount(void) {
+	int count = 0;
+
+	for (int i = 0; i < VOXEL_GRID_CHUNKS_X * VOXEL_GRID_CHUNKS_Y * VOXEL_GRID_CHUNKS_Z; i++) {
+		if (chunk_buffer[i].IsCompressed()) count++;
+	}
+
+	return count;
+}
+
+int VoxelGrid::Update(void) {
+	// Each chunk going cold may allocate its compressed form, and nothing else here is allowed to touch the heap.
+
+	int compressed = 0;
+	access_tick++;
+
+	for (int i = 0; i < VOXEL_GRID_CHUNKS_X * VOXEL_GRID_CHUNKS_Y * VOXEL_GRID_CHUNKS_Z; i++) {
+		VoxelChunk* chunk = &chunk_buffer[i];
+
+		if (chunk->IsUniform() || chunk->IsCompacted()) continue;
+		if (access_tick - chunk->GetLastAccess() < VOXEL_CHUNK_COLD_TICKS) continue;
+
+		MemoryTracker::AllowAllocations(VOXEL_CHUNK_COMPRESS_ALLOCATIONS);
+		chunk->Compress();
+		MemoryTracker::AllowAllocations(0);
+
+		compressed++;
+	}
+
+	return compressed;
 }
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Voxel.h"
+#include "VoxelChunk.h"
+#include "DrawList.h"
+#include "RenderBackend.h"
 
 #ifndef VOXEL_GRID_SIZE_X
 #define VOXEL_GRID_SIZE_X 128
@@ -14,6 +17,20 @@
 #define VOXEL_GRID_SIZE_Z 128
 #endif
 
+#ifndef VOXEL_CHUNK_COLD_TICKS
+#define VOXEL_CHUNK_COLD_TICKS 120
+#endif
+
+#define VOXEL_GRID_CHUNKS_X ((VOXEL_GRID_SIZE_X + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE)
+#define VOXEL_GRID_CHUNKS_Y ((VOXEL_GRID_SIZE_Y + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE)
+#define VOXEL_GRID_CHUNKS_Z ((VOXEL_GRID_SIZE_Z + VOXEL_CHUNK_SIZE - 1) / VOXEL_CHUNK_SIZE)
+
+// The grid is split into VoxelChunks, which collapse uniform regions and palette-compress mixed ones.
+// Call Update() once per frame : chunks which haven't been written for VOXEL_CHUNK_COLD_TICKS updates get compressed.
+// Compressing a chunk may allocate up to VOXEL_CHUNK_COMPRESS_ALLOCATIONS blocks even in the steady state. MemoryTracker counts those as exempt.
+// The grid keeps one DrawList of all its triangles, rebuilt only after voxels change. DrawAll() hands it to a RenderBackend.
+// Voxels passed to SetVoxel() belong to the grid from then on, and voxels returned by GetVoxel() are shared and read-only.
+
 class VoxelGrid {
 public:
 	VoxelGrid(void);
@@ -22,7 +39,16 @@ public:
 	void SetVoxel(int x, int y, int z, Voxel* target);
 	bool VoxelPresent(int x, int y, int z);
 	Voxel* GetVoxel(int x, int y, int z);
-	void DrawAll(void);
+	void DrawAll(RenderBackend* backend);
+	DrawList* GetDrawList(void);
+	int Update(void); // Returns how many chunks were compressed.
+	int GetCompressedChunkCount(void);
 private:
-	Voxel**** voxel_buffer; // Quadruple pointer. Wow!
+	VoxelChunk* FindChunk(int index_x, int index_y, int index_z, int* cell);
+	void BuildDrawList(void);
+
+	VoxelChunk* chunk_buffer;
+	unsigned int access_tick;
+	unsigned int revision;
+	DrawList draw_list;
 };
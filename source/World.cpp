@@ -0,0 +1,233 @@
+#include "World.h"
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+static const float gravity = 0.01f;
+
+void GenerateVoxelMap(VoxelGrid* target_voxel_grid) {
+	/* Instead of using a stack-allocated Voxel array, we will dynamically push Voxel objects to the grid.
+	 * This allows for much less memory-based data copying.
+	 * This does come at the detriment of being limited in the amount of Voxels.
+	 */
+
+	// We place a 20x20 simple floor and ceiling.
+
+	// Floors / Ceilings.
+
+	GenerateBlock(-20, 0, -20, 20, 0, 20, target_voxel_grid, 0.2f, 0.6f, 0.1f);
+	GenerateBlock(-20, 10, -20, 20, 10, 20, target_voxel_grid, 0.0f, 0.8f, 1.0f);
+	GenerateBlock(-20, 20, -20, 20, 20, 20, target_voxel_grid, 0.1f, 0.1f, 0.1f);
+
+	// FB walls.
+
+	GenerateBlock(-20, 1, -20, 20, 20, -20, target_voxel_grid, 0.2f, 0.2f, 0.2f);
+	GenerateBlock(-20, 1, 20, 20, 20, 20, target_voxel_grid, 0.2f, 0.2f, 0.2f);
+
+	// LR walls.
+
+	GenerateBlock(-20, 1, -19, -20, 19, 19, target_voxel_grid, 0.2f, 0.2f, 0.2f);
+	GenerateBlock(20, 1, -19, 20, 19, 19, target_voxel_grid, 0.2f, 0.2f, 0.2f);
+
+	GenerateBlock(-1, 1, -6, 1, 2, -4, target_voxel_grid, 0.4f, 0.1f, 0.4f);
+	GenerateBlock(-4, 1, -6, -4, 4, -4, target_voxel_grid, 0.2f, 0.1f, 0.5f);
+	GenerateBlock(-8, 1, -7, -5, 5, -5, target_voxel_grid, 0.1f, 0.4f, 0.3f);
+	GenerateBlock(-8, 1, -1, -8, 3, 1, target_voxel_grid, 0.5f, 0.5f, 0.1f);
+	GenerateBlock(-6, 1, 3, -4, 5, 5, target_voxel_grid, 0.2f, 0.4f, 0.4f);
+	GenerateBlock(-6, 1, 8, -4, 6, 13, target_voxel_grid, 0.2f, 0.1f, 0.2f);
+	GenerateBlock(-6, 5, 10, -4, 7, 13, target_voxel_grid, 0.2f, 0.1f, 0.2f);
+	GenerateBlock(-6, 7, 12, -4, 9, 13, target_voxel_grid, 0.2f, 0.1f, 0.2f, Voxel::VoxelShape::Cuboid);
+	GenerateBlock(-19, 11, -19, 19, 11, 19, target_voxel_grid, 0.6f, 0.0f, 0.0f, Voxel::VoxelShape::Pyramid);
+	GenerateBlock(-6, 11, 0, -4, 11, 10, target_voxel_grid, 0.2f, 0.1f, 0.2f);
+	GenerateBlock(-7, 11, -10, -3, 13, -5, target_voxel_grid, 0.2f, 0.1f, 0.2f);
+	GenerateBlock(0, 11, -10, 5, 15, -5, target_voxel_grid, 0.2f, 0.1f, 0.2f);
+	GenerateBlock(5, 1, -10, 15, 5, 10, target_voxel_grid, 0.2f, 0.1f, 0.2f);
+	GenerateBlock(-7, 17, -7, 0, 17, 0, target_voxel_grid, 0.2f, 0.1f, 0.2f);
+	SliceBlock(-7, 1, -6, -6, 5, -5, target_voxel_grid);
+	SliceBlock(-7, 1, -7, -6, 2, -7, target_voxel_grid);
+	SliceBlock(-10, 10, 11, 0, 11, 13, target_voxel_grid);
+}
+
+void StepCamera(VoxelGrid* grid, Camera* camera, unsigned int input) {
+	const float camera_speed = 0.01f;
+
+	if (input & InputStream::LookRight) camera->angle += 0.04f;
+	if (input & InputStream::LookLeft) camera->angle -= 0.04f;
+
+	if (input & InputStream::StrafeLeft) {
+		camera->xspeed += cos(camera->angle - (3.141f / 2.0f)) * camera_speed;
+		camera->zspeed += sin(camera->angle - (3.141f / 2.0f)) * camera_speed;
+	}
+
+	if (input & InputStream::StrafeRight) {
+		camera->xspeed += cos(camera->angle + (3.141f / 2.0f)) * camera_speed;
+		camera->zspeed += sin(camera->angle + (3.141f / 2.0f)) * camera_speed;
+	}
+
+	if (input & InputStream::Forward) {
+		camera->xspeed += cos(camera->angle) * camera_speed;
+		camera->zspeed += sin(camera->angle) * camera_speed;
+	}
+
+	if (input & InputStream::Backward) {
+		camera->xspeed += -cos(camera->angle) * camera_speed;
+		camera->zspeed += -sin(camera->angle) * camera_speed;
+	}
+
+	camera->yspeed -= gravity;
+	camera->zspeed /= 1.05f;
+	camera->xspeed /= 1.05f;
+
+	// Now, we check for collisions with other blocks.
+
+	// I've never done a triple loop like this, but as we need to iterate 3 dimensions..
+	for (int x = -20; x <= 20; x++) for (int y = -20; y <= 20; y++) for (int z = -20; z <= 20; z++) {
+		if (!grid->VoxelPresent(x, y, z)) continue;
+		if (grid->GetVoxel(x, y, z)->IsFullyOccluded()) continue;
+		// There is a voxel at the current location.
+
+		bool overlap_x = (camera->x + camera->width / 2.0f > x - 0.5f && camera->x - camera->width / 2.0f < x + 0.5f);
+		bool overlap_future_x = (camera->x + camera->xspeed + camera->width / 2.0f >= x - 0.5f && camera->x + camera->xspeed - camera->width / 2.0f <= x + 0.5f);
+
+		bool overlap_y = (camera->y > y - 0.5f && camera->y - camera->height < y + 0.5f);
+		bool overlap_future_y = (camera->y + camera->yspeed >= y - 0.5f && camera->y + camera->yspeed - camera->height <= y + 0.5f);
+
+		bool overlap_z = (camera->z + camera->length / 2.0f > z - 0.5f && camera->z - camera->length / 2.0f < z + 0.5f);
+		bool overlap_future_z = (camera->z + camera->zspeed + camera->length / 2.0f >= z - 0.5f && camera->z + camera->zspeed - camera->length / 2.0f <= z + 0.5f);
+
+		if (overlap_future_y && overlap_x && overlap_z) {
+			if (camera->yspeed < 0.0f) {
+				camera->y = y + 0.5f + camera->height;
+				camera->yspeed = 0.0f;
+
+				if (grid->GetVoxel(x, y, z)->GetDrawMode() == Voxel::Pyramid) {
+					camera->x = 0.0f;
+					camera->y = 0.5f + camera->height;
+					camera->z = 0.0f;
+					camera->xspeed = 0.0f;
+					camera->yspeed = 0.0f;
+					camera->zspeed = 0.0f;
+				}
+
+				if (input & InputStream::Jump) camera->yspeed = 0.2f;
+			} else if (camera->yspeed > 0.0f) {
+				camera->y = y - 0.5f;
+				camera->yspeed = 0.0f;
+			}
+		}
+
+		if (!overlap_z && overlap_future_z && overlap_y && overlap_x) {
+			if (camera->zspeed < 0.0f) {
+				camera->z = z + 0.5f + camera->length / 2.0f;
+				camera->zspeed = 0.0f;
+			} else if (camera->zspeed > 0.0f) {
+				camera->z = z - 0.5f - camera->length / 2.0f;
+				camera->zspeed = 0.0f;
+			}
+		}
+
+		if (!overlap_x && overlap_future_x && overlap_y && overlap_z) {
+			if (camera->xspeed < 0.0f) {
+				camera->x = x + 0.5f + camera->width / 2.0f;
+				camera->xspeed = 0.0f;
+			} else if (camera->xspeed > 0.0f) {
+				camera->x = x - 0.5f - camera->width / 2.0f;
+				camera->xspeed = 0.0f;
+			}
+		}
+	}
+
+	camera->x += camera->xspeed;
+	camera->y += camera->yspeed;
+	camera->z += camera->zspeed;
+}
+
+void GenerateBlock(int x1, int y1, int z1, int x2, int y2, int z2, VoxelGrid* target_grid, float r, float g, float b, Voxel::VoxelShape shape) {
+	// Useful debugging function.
+	// printf("[GenerateBlock] Recieved %d, %d, %d, %d, %d, %d\n", x1, y1, z1, x2, y2, z2);
+
+	bool occlude[6] = {0};
+
+	// This is where the occlusion algorithm takes place.
+	// 0 : Front, 1 : Back, 2 : Top , 3 : Bottom, 4 : Right, 5 : Left
+	for (int x = x1; x <= x2; x++) for (int y = y1; y <= y2; y++) for (int z = z1; z <= z2; z++) {
+		target_grid->SetVoxel(x, y, z, new Voxel(0.0f, 0.0f, 0.0f, occlude, shape));
+	}
+
+	for (int x = x1; x <= x2; x++) for (int y = y1; y <= y2; y++) for (int z = z1; z <= z2; z++) {
+		for (int i = 0; i < 6; i++) occlude[i] = false;
+
+		if (target_grid->VoxelPresent(x - 1, y, z)) if (target_grid->GetVoxel(x - 1, y, z)->GetDrawMode() == Voxel::Cuboid) occlude[5] = true;
+		if (target_grid->VoxelPresent(x + 1, y, z)) if (target_grid->GetVoxel(x + 1, y, z)->GetDrawMode() == Voxel::Cuboid) occlude[4] = true;
+		if (target_grid->VoxelPresent(x, y + 1, z)) if (target_grid->GetVoxel(x, y + 1, z)->GetDrawMode() == Voxel::Cuboid) occlude[2] = true;
+		if (target_grid->VoxelPresent(x, y - 1, z)) if (target_grid->GetVoxel(x, y - 1, z)->GetDrawMode() == Voxel::Cuboid) occlude[3] = true;
+		if (target_grid->VoxelPresent(x, y, z + 1)) if (target_grid->GetVoxel(x, y, z + 1)->GetDrawMode() == Voxel::Cuboid) occlude[0] = true;
+		if (target_grid->VoxelPresent(x, y, z - 1)) if (target_grid->GetVoxel(x, y, z - 1)->GetDrawMode() == Voxel::Cuboid) occlude[1] = true;
+
+		target_grid->SetVoxel(x, y, z, new Voxel(r, g, b, occlude, shape));
+	}
+}
+
+void SliceBlock(int x1, int y1, int z1, int x2, int y2, int z2, VoxelGrid* target) {
+	for (int x = x1; x <= x2; x++) for (int y = y1; y <= y2; y++) for (int z = z1; z <= z2; z++) {
+		target->SetVoxel(x, y, z, NULL);
+	}
+
+	for (int x = x1 - 1; x <= x2 + 1; x++) for (int y = y1 - 1; y <= y2 + 1; y++) for (int z = z1 - 1; z <= z2 + 1; z++) {
+		if (x == x1 - 1 || x == x2 + 1 || y == y1 - 1 || y == y2 + 1 || z == z1 - 1 || z == z2 + 1) {
+			// Recalculate the occlusion buffer for this voxel, it is on the outline.
+
+			if (!target->GetVoxel(x, y, z)) continue;
+			Voxel::VoxelShape shape = target->GetVoxel(x, y, z)->GetDrawMode();
+
+			bool occlude[6] = {0};
+			// Fix cuboid / pyramid occlusion here.
+
+			if (target->VoxelPresent(x - 1, y, z)) if (target->GetVoxel(x - 1, y, z)->GetDrawMode() == Voxel::Cuboid) occlude[5] = true;
+			if (target->VoxelPresent(x + 1, y, z)) if (target->GetVoxel(x + 1, y, z)->GetDrawMode() == Voxel::Cuboid) occlude[4] = true;
+			if (target->VoxelPresent(x, y + 1, z)) if (target->GetVoxel(x, y + 1, z)->GetDrawMode() == Voxel::Cuboid) occlude[2] = true;
+			if (target->VoxelPresent(x, y - 1, z)) if (target->GetVoxel(x, y - 1, z)->GetDrawMode() == Voxel::Cuboid) occlude[3] = true;
+			if (target->VoxelPresent(x, y, z + 1)) if (target->GetVoxel(x, y, z + 1)->GetDrawMode() == Voxel::Cuboid) occlude[0] = true;
+			if (target->VoxelPresent(x, y, z - 1)) if (target->GetVoxel(x, y, z - 1)->GetDrawMode() == Voxel::Cuboid) occlude[1] = true;
+
+			float r, g, b;
+			target->GetVoxel(x, y, z)->GetColor(&r, &g, &b);
+
+			target->SetVoxel(x, y, z, new Voxel(r, g, b, occlude, shape));
+		}
+	}
+}
+
+void SetCameraView(Camera* camera, RenderView* view) {
+	view->eye_x = camera->x;
+	view->eye_y = camera->y;
+	view->eye_z = camera->z;
+
+	view->target_x = camera->x + cos(camera->angle);
+	view->target_y = camera->y;
+	view->target_z = camera->z + sin(camera->angle);
+}
+
+static unsigned int ChecksumBytes(unsigned int hash, const void* data, size_t size) {
+	// FNV-1a. Floats are hashed bit for bit, so any drift in the simulation shows up.
+
+	const unsigned char* bytes = (const unsigned char*) data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+unsigned int ChecksumState(Camera* camera, DrawList* draw_list) {
+	unsigned int hash = 2166136261u;
+
+	hash = ChecksumBytes(hash, camera, sizeof(Camera));
+	hash = ChecksumBytes(hash, draw_list->GetVertices(), sizeof(DrawVertex) * draw_list->GetVertexCount());
+
+	return hash;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Voxel.h"
+#include "VoxelGrid.h"
+#include "DrawList.h"
+#include "Input.h"
+#include "RenderBackend.h"
+
+// Everything a frame does that doesn't need a window : map generation and camera physics.
+// Both the interactive program and the headless replay run through these, so a recorded input file reproduces a session exactly.
+
+struct Camera {
+	float x = 0.0f, y = 2.5f, z = 0.0f;
+	float angle = 0.0f;
+	float width = 1.0f; // Width : X
+	float height = 1.5f; // Height : Y
+	float length = 1.0f; // Length : Z
+	float xspeed = 0.0f;
+	float yspeed = 0.0f;
+	float zspeed = 0.0f;
+};
+
+void GenerateVoxelMap(VoxelGrid* target_voxel_grid);
+void GenerateBlock(int x1, int y1, int z1, int x2, int y2, int z2, VoxelGrid* target, float r, float g, float b, Voxel::VoxelShape shape = Voxel::VoxelShape::Cuboid);
+void SliceBlock(int x1, int y1, int z1, int x2, int y2, int z2, VoxelGrid* target);
+
+void StepCamera(VoxelGrid* grid, Camera* camera, unsigned int input);
+void SetCameraView(Camera* camera, RenderView* view);
+unsigned int ChecksumState(Camera* camera, DrawList* draw_list);